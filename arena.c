@@ -0,0 +1,103 @@
+#include <stdlib.h>
+
+#include "arena.h"
+
+#define CHUNK_HEADER_SIZE ARENA_ROUND(sizeof(arena_chunk))
+#define CHUNK_DATA(chunk) ((char *) (chunk) + CHUNK_HEADER_SIZE)
+
+static arena_chunk *spare_chunks = NULL;
+static unsigned int count_spare_chunks = 0;
+
+arena_chunk *make_arena_chunk(unsigned int size)
+{
+    arena_chunk *chunk;
+
+    if (size == ARENA_CHUNK_SIZE && spare_chunks != NULL) {
+        chunk = spare_chunks;
+        spare_chunks = chunk->next;
+        --count_spare_chunks;
+    } else {
+        chunk = (arena_chunk *) malloc(CHUNK_HEADER_SIZE + size);
+        chunk->size = size;
+    }
+
+    chunk->next = NULL;
+    chunk->used = 0;
+    return chunk;
+}
+
+void destroy_arena_chunk(arena_chunk *chunk)
+{
+    if (chunk->size == ARENA_CHUNK_SIZE
+        && count_spare_chunks < ARENA_SPARE_CHUNKS)
+    {
+        chunk->next = spare_chunks;
+        spare_chunks = chunk;
+        ++count_spare_chunks;
+        return;
+    }
+
+    free(chunk);
+}
+
+/* Arena itself lives in its first chunk. */
+arena *make_arena(void)
+{
+    arena_chunk *chunk = make_arena_chunk(ARENA_CHUNK_SIZE);
+    arena *a = (arena *) CHUNK_DATA(chunk);
+
+    chunk->used = ARENA_ROUND(sizeof(arena));
+    a->refs = 1;
+    a->chunk = chunk;
+    a->line = NULL;
+    a->base = NULL;
+    return a;
+}
+
+void *arena_alloc(arena *a, unsigned int size)
+{
+    arena_chunk *chunk = a->chunk;
+    unsigned int chunk_size;
+    void *ptr;
+
+    size = ARENA_ROUND(size);
+
+    if (chunk->used + size > chunk->size) {
+        chunk_size = chunk->size * 2;
+        if (chunk_size > ARENA_MAX_CHUNK_SIZE)
+            chunk_size = ARENA_MAX_CHUNK_SIZE;
+        if (chunk_size < size)
+            chunk_size = size;
+
+        chunk = make_arena_chunk(chunk_size);
+        chunk->next = a->chunk;
+        a->chunk = chunk;
+    }
+
+    ptr = CHUNK_DATA(chunk) + chunk->used;
+    chunk->used += size;
+    return ptr;
+}
+
+void ref_arena(arena *a)
+{
+    ++(a->refs);
+}
+
+void release_arena(arena *a)
+{
+    arena_chunk *chunk;
+    arena_chunk *next;
+
+    if (a == NULL || --(a->refs) > 0)
+        return;
+
+    release_input_line(a->line);
+    release_arena(a->base);
+
+    /* First chunk (with arena) is last in list */
+    for (chunk = a->chunk; chunk != NULL; chunk = next) {
+        next = chunk->next;
+        destroy_arena_chunk(chunk);
+    }
+}
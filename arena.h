@@ -0,0 +1,55 @@
+#ifndef ARENA_H_SENTRY
+#define ARENA_H_SENTRY
+
+#include "input.h"
+
+/* Size of usual chunk. Arena started with
+ * one such chunk, next chunks are bigger. */
+#ifndef ARENA_CHUNK_SIZE
+#define ARENA_CHUNK_SIZE 4096
+#endif
+
+#ifndef ARENA_MAX_CHUNK_SIZE
+#define ARENA_MAX_CHUNK_SIZE (1024 * 1024)
+#endif
+
+/* Count of freed usual chunks, which
+ * kept for next arenas. */
+#ifndef ARENA_SPARE_CHUNKS
+#define ARENA_SPARE_CHUNKS 4
+#endif
+
+typedef union arena_align {
+    long l;
+    double d;
+    void *p;
+} arena_align;
+
+#define ARENA_ROUND(size) (((size) + sizeof(arena_align) - 1) \
+    / sizeof(arena_align) * sizeof(arena_align))
+
+typedef struct arena_chunk {
+    struct arena_chunk *next;
+    unsigned int size;
+    unsigned int used;
+} arena_chunk;
+
+/* Memory of one command line: lexemes, parse
+ * tree, argv arrays and jobs. Freed at once,
+ * when nobody refer to it. */
+typedef struct arena {
+    int refs;
+    arena_chunk *chunk; /* current, others via next */
+    /* Words of command line, released with arena */
+    input_line *line;
+    /* Retained arena, for example cached plan
+     * of command line, released with arena */
+    struct arena *base;
+} arena;
+
+arena *make_arena(void);
+void *arena_alloc(arena *a, unsigned int size);
+void ref_arena(arena *a);
+void release_arena(arena *a);
+
+#endif
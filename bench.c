@@ -0,0 +1,219 @@
+/* For fileno(), fork() and getrusage() */
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include "bench.h"
+
+#define COUNT(array) (sizeof(array) / sizeof(*(array)))
+
+unsigned long bench_allocs = 0;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t nmemb, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size)
+{
+    ++bench_allocs;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t nmemb, size_t size)
+{
+    ++bench_allocs;
+    return __real_calloc(nmemb, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    ++bench_allocs;
+    return __real_realloc(ptr, size);
+}
+
+static const char *corpus_names[] = {
+    "mixed", "long words", "quoted", "parens", "pipelines", "lists",
+    "repeated"
+};
+
+/* Distinct lines of repeated corpus */
+#define BENCH_REPEATED_LINES 32
+
+static const char *mixed_words[] = {
+    "ls", "-la", "/usr/local/share/doc/some-package/README.Debian.gz",
+    "\"quoted string with spaces\"", "esc\\ aped\\ word", "\"a \\\"b\\\" c\"",
+    "--option=value", "x", "file.txt"
+};
+
+static const char *mixed_operators[] = {
+    " | ", " || ", " && ", " ; ", " > ", " >> ", " < ", " "
+};
+
+static const char *quoted_words[] = {
+    "\"quoted string with spaces\"", "esc\\ aped\\ word",
+    "\"a \\\"b\\\" c\"", "half\" quoted \"word", "\\|\\&\\;\\(\\)",
+    "\"multi\\\nline\"", "\"\\\\back\\\\slashes\\\\\"", "a\\\"b\\\"c"
+};
+
+static const char *list_operators[] = {
+    " && ", " || ", " ; "
+};
+
+static const char word_symbols[] =
+    "abcdefghijklmnopqrstuvwxyz0123456789._-/";
+
+const char *bench_corpus_name(bench_corpus corpus)
+{
+    return corpus_names[corpus];
+}
+
+void put_random_word(FILE *f, unsigned int len)
+{
+    while (len-- > 0)
+        putc(word_symbols[rand() % (COUNT(word_symbols) - 1)], f);
+}
+
+void generate_line(FILE *f, bench_corpus corpus)
+{
+    static unsigned int repeated = 0;
+    unsigned int i, count;
+
+    switch (corpus) {
+    case BC_REPEATED:
+        srand(1 + repeated++ % BENCH_REPEATED_LINES);
+        generate_line(f, BC_MIXED);
+        break;
+    case BC_MIXED:
+        count = 1 + rand() % 16;
+        for (i = 0; i < count; ++i) {
+            fputs(mixed_words[rand() % COUNT(mixed_words)], f);
+            fputs((i + 1 == count) ? "" :
+                mixed_operators[rand() % COUNT(mixed_operators)], f);
+        }
+        fputs((rand() % 10 == 0) ? " &\n" : "\n", f);
+        break;
+    case BC_LONG_WORDS:
+        fputs("cmd", f);
+        count = 1 + rand() % 4;
+        for (i = 0; i < count; ++i) {
+            putc(' ', f);
+            put_random_word(f, 1024 + rand() % 8192);
+        }
+        putc('\n', f);
+        break;
+    case BC_QUOTED:
+        fputs("echo", f);
+        count = 1 + rand() % 16;
+        for (i = 0; i < count; ++i) {
+            putc(' ', f);
+            fputs(quoted_words[rand() % COUNT(quoted_words)], f);
+        }
+        putc('\n', f);
+        break;
+    case BC_PARENS:
+        count = 1 + rand() % 64;
+        for (i = 0; i < count; ++i)
+            fputs("( ", f);
+        fputs("ls -l", f);
+        for (i = 0; i < count; ++i)
+            fputs(" )", f);
+        putc('\n', f);
+        break;
+    case BC_PIPELINES:
+        fputs("cat file.txt", f);
+        count = 16 + rand() % 128;
+        for (i = 0; i < count; ++i) {
+            fputs(" | grep -v ", f);
+            put_random_word(f, 1 + rand() % 8);
+        }
+        fputs(" > out\n", f);
+        break;
+    case BC_LISTS:
+        fputs("true", f);
+        count = 16 + rand() % 128;
+        for (i = 0; i < count; ++i) {
+            fputs(list_operators[rand() % COUNT(list_operators)], f);
+            fputs("test -f ", f);
+            put_random_word(f, 1 + rand() % 8);
+        }
+        putc('\n', f);
+        break;
+    case BC_COUNT:
+        break;
+    }
+}
+
+unsigned long bench_corpus_to_stdin(bench_corpus corpus)
+{
+    FILE *f = tmpfile();
+    long bytes;
+
+    if (f == NULL) {
+        perror("tmpfile()");
+        return 0;
+    }
+
+    srand(1);
+    while (ftell(f) < BENCH_CORPUS_SIZE)
+        generate_line(f, corpus);
+    fflush(f);
+
+    bytes = ftell(f);
+    if (dup2(fileno(f), STDIN_FILENO) == -1) {
+        perror("dup2()");
+        return 0;
+    }
+    fclose(f);
+    lseek(STDIN_FILENO, 0, SEEK_SET);
+
+    return bytes;
+}
+
+long bench_peak_rss(void)
+{
+    struct rusage usage;
+
+    if (getrusage(RUSAGE_SELF, &usage) == -1)
+        return 0;
+    return usage.ru_maxrss;
+}
+
+int bench_run_all(const char *header, int (*func)(bench_corpus corpus))
+{
+    int corpus;
+    int status;
+    int failed = 0;
+    pid_t pid;
+
+    printf("%s\n", header);
+    fflush(stdout);
+
+    for (corpus = 0; corpus < BC_COUNT; ++corpus) {
+        pid = fork();
+        if (pid == -1) {
+            perror("fork()");
+            return 1;
+        }
+
+        if (pid == 0) {
+            status = func(corpus);
+            fflush(stdout);
+            _exit(status);
+        }
+
+        if (waitpid(pid, &status, 0) == -1
+            || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        {
+            fprintf(stderr, "%s: failed\n", corpus_names[corpus]);
+            failed = 1;
+        }
+    }
+
+    return failed;
+}
@@ -0,0 +1,45 @@
+#ifndef BENCH_H_SENTRY
+#define BENCH_H_SENTRY
+
+/* Common part of benchmark drivers (see `make bench`):
+ * generated corpus, allocation counter and peak RSS. */
+
+#include <stdio.h>
+
+/* Approximate size of each generated corpus */
+#ifndef BENCH_CORPUS_SIZE
+#define BENCH_CORPUS_SIZE (16 * 1024 * 1024)
+#endif
+
+typedef enum bench_corpus {
+    BC_MIXED,      /* words and operators of all kinds */
+    BC_LONG_WORDS, /* plain words of kilobytes */
+    BC_QUOTED,     /* heavily quoted and escaped words */
+    BC_PARENS,     /* deep parenthesis nesting */
+    BC_PIPELINES,  /* long pipelines */
+    BC_LISTS,      /* many list operators */
+    BC_REPEATED,   /* few mixed lines repeated */
+    BC_COUNT
+} bench_corpus;
+
+/* Calls of malloc(), calloc() and realloc() from
+ * shell modules. Counted only if linked with
+ * -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc */
+extern unsigned long bench_allocs;
+
+const char *bench_corpus_name(bench_corpus corpus);
+
+/* Generate corpus to temporary file and make it
+ * standard input. Returns size in bytes or 0 on
+ * error. */
+unsigned long bench_corpus_to_stdin(bench_corpus corpus);
+
+/* Run func(corpus) for each corpus in separate
+ * process, so peak RSS measured for each one.
+ * Returns 0, if all runs succeeded. */
+int bench_run_all(const char *header, int (*func)(bench_corpus corpus));
+
+/* Peak RSS of current process in kilobytes */
+long bench_peak_rss(void);
+
+#endif
@@ -0,0 +1,60 @@
+/* Microbenchmark for buffer backends: fill buffer
+ * with word of given size symbol by symbol and
+ * convert it to string, as lexer does. Built
+ * for both backends and runned by `make bench`:
+ * bench_buffer_array and bench_buffer_list. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "buffer.h"
+
+/* Symbols per word size */
+#define BENCH_TOTAL_SYMBOLS (1 << 25)
+
+static const unsigned int word_sizes[] = {
+    1, 8, 64, 1024, 65536, 1048576
+};
+
+double bench_word_size(unsigned int word_size)
+{
+    unsigned int words = BENCH_TOTAL_SYMBOLS / word_size;
+    unsigned int i, j;
+    clock_t start;
+    buffer buf;
+    char *str;
+
+    new_buffer(&buf);
+    start = clock();
+
+    for (i = 0; i < words; ++i) {
+        for (j = 0; j < word_size; ++j)
+            add_to_buffer(&buf, 'a' + j % 26);
+        str = convert_to_string(&buf, 1);
+        free(str);
+    }
+
+    return (double) (clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main()
+{
+    unsigned int i;
+    double seconds;
+
+#ifdef BUFFER_ARRAY
+    printf("Backend: array\n");
+#else
+    printf("Backend: list of %d-byte blocks\n", BUFFER_BLOCK_SIZE);
+#endif
+
+    for (i = 0; i < sizeof(word_sizes) / sizeof(*word_sizes); ++i) {
+        seconds = bench_word_size(word_sizes[i]);
+        printf("word size %8u: %8.3f s, %6.2f ns/symbol\n",
+            word_sizes[i], seconds,
+            seconds * 1e9 / BENCH_TOTAL_SYMBOLS);
+    }
+
+    return 0;
+}
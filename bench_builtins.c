@@ -0,0 +1,143 @@
+/* Commands per second of ./shell running script
+ * of echo, printf, test, [, true, false and pwd:
+ * built in and as external commands (by full
+ * names). Built and runned by `make bench`
+ * after shell. */
+
+/* For mkstemp() and fdopen() */
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+#include "bench.h"
+
+#define BENCH_SHELL "./shell"
+
+/* Lines of script, each one of
+ * BENCH_LINE_CMDS commands */
+#define BENCH_LINES 2000
+#define BENCH_LINE_CMDS 8
+
+/* Script line, %s replaced by utility names */
+#define BENCH_LINE "%s a b c; %s \"%%s-%%d\\n\" x 1; " \
+    "%s -d /tmp && %s; %s 1 -eq 2 ] || %s; %s; %s x\n"
+
+static const char *utilities[] = {
+    "echo", "printf", "test", "true", "[", "false", "pwd", "echo"
+};
+
+#define COUNT(array) (sizeof(array) / sizeof(*(array)))
+
+/* Full name of utility in /bin or /usr/bin */
+const char *external_name(const char *name, char *file)
+{
+    sprintf(file, "/bin/%s", name);
+    if (access(file, X_OK) == 0)
+        return file;
+    sprintf(file, "/usr/bin/%s", name);
+    if (access(file, X_OK) == 0)
+        return file;
+    return NULL;
+}
+
+/* Returns descriptor of script or -1 */
+int make_script(int external)
+{
+    char files[COUNT(utilities)][64];
+    const char *names[COUNT(utilities)];
+    char path[] = "/tmp/bench_builtins_XXXXXX";
+    unsigned int i;
+    FILE *script;
+    int fd;
+
+    for (i = 0; i < COUNT(utilities); ++i) {
+        names[i] = external ?
+            external_name(utilities[i], files[i]) : utilities[i];
+        if (names[i] == NULL) {
+            fprintf(stderr, "%s: not found\n", utilities[i]);
+            return -1;
+        }
+    }
+
+    fd = mkstemp(path);
+    if (fd == -1) {
+        perror("mkstemp()");
+        return -1;
+    }
+    unlink(path);
+
+    script = fdopen(dup(fd), "w");
+    for (i = 0; i < BENCH_LINES; ++i) {
+        fprintf(script, BENCH_LINE, names[0], names[1], names[2],
+            names[3], names[4], names[5], names[6], names[7]);
+    }
+    fclose(script);
+
+    lseek(fd, 0, SEEK_SET);
+    return fd;
+}
+
+/* Returns commands per second or -1 on error */
+double bench_script(int external)
+{
+    struct timeval start, end;
+    int fd = make_script(external);
+    int null_fd;
+    int status;
+    pid_t pid;
+
+    if (fd == -1)
+        return -1;
+
+    gettimeofday(&start, NULL);
+
+    pid = fork();
+    if (pid == -1) {
+        perror("fork()");
+        return -1;
+    }
+    if (pid == 0) {
+        null_fd = open("/dev/null", O_WRONLY);
+        dup2(fd, STDIN_FILENO);
+        dup2(null_fd, STDOUT_FILENO);
+        execl(BENCH_SHELL, BENCH_SHELL, (char *) NULL);
+        perror(BENCH_SHELL);
+        _exit(127);
+    }
+
+    close(fd);
+    if (waitpid(pid, &status, 0) == -1 || !WIFEXITED(status)
+        || WEXITSTATUS(status) == 127)
+    {
+        fprintf(stderr, "%s: bad run\n", BENCH_SHELL);
+        return -1;
+    }
+
+    gettimeofday(&end, NULL);
+    return BENCH_LINES * BENCH_LINE_CMDS
+        / ((end.tv_sec - start.tv_sec)
+            + (end.tv_usec - start.tv_usec) / 1e6);
+}
+
+int main()
+{
+    double builtin, external;
+
+    builtin = bench_script(0);
+    external = bench_script(1);
+    if (builtin < 0 || external < 0)
+        return 1;
+
+    printf("Builtins\n");
+    printf("             commands/s\n");
+    printf("%-12s %10.0f\n", "built in", builtin);
+    printf("%-12s %10.0f\n", "external", external);
+    return 0;
+}
@@ -0,0 +1,103 @@
+/* Launch and reap of many short background
+ * jobs by ./shell: thousands of jobs are in
+ * job table at once. Built and runned by
+ * `make bench` after shell. */
+
+/* For mkstemp() and fdopen() */
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+#include "bench.h"
+
+#define BENCH_SHELL "./shell"
+
+#define BENCH_JOBS 10000
+
+/* Each job lives so long */
+#define BENCH_JOB "/bin/sleep 1 &\n"
+
+/* Last line waits for all jobs, its time
+ * not counted */
+#define BENCH_WAIT "/bin/sleep 1.5\n"
+#define BENCH_WAIT_SECONDS 1.5
+
+/* Returns descriptor of script or -1 */
+int make_script(void)
+{
+    char path[] = "/tmp/bench_jobs_XXXXXX";
+    unsigned int i;
+    FILE *script;
+    int fd;
+
+    fd = mkstemp(path);
+    if (fd == -1) {
+        perror("mkstemp()");
+        return -1;
+    }
+    unlink(path);
+
+    script = fdopen(dup(fd), "w");
+    fprintf(script, "launcher spawn\n");
+    for (i = 0; i < BENCH_JOBS; ++i)
+        fprintf(script, BENCH_JOB);
+    /* Jobs reported before next line */
+    fprintf(script, BENCH_WAIT "true\n");
+    fclose(script);
+
+    lseek(fd, 0, SEEK_SET);
+    return fd;
+}
+
+int main()
+{
+    struct timeval start, end;
+    double seconds;
+    int fd = make_script();
+    int null_fd;
+    int status;
+    pid_t pid;
+
+    if (fd == -1)
+        return 1;
+
+    gettimeofday(&start, NULL);
+
+    pid = fork();
+    if (pid == -1) {
+        perror("fork()");
+        return 1;
+    }
+    if (pid == 0) {
+        null_fd = open("/dev/null", O_WRONLY);
+        dup2(fd, STDIN_FILENO);
+        dup2(null_fd, STDOUT_FILENO);
+        execl(BENCH_SHELL, BENCH_SHELL, (char *) NULL);
+        perror(BENCH_SHELL);
+        _exit(127);
+    }
+
+    close(fd);
+    if (waitpid(pid, &status, 0) == -1 || !WIFEXITED(status)
+        || WEXITSTATUS(status) != 0)
+    {
+        fprintf(stderr, "%s: bad run\n", BENCH_SHELL);
+        return 1;
+    }
+
+    gettimeofday(&end, NULL);
+    seconds = (end.tv_sec - start.tv_sec)
+        + (end.tv_usec - start.tv_usec) / 1e6 - BENCH_WAIT_SECONDS;
+
+    printf("Jobs\n");
+    printf("      jobs    seconds     jobs/s\n");
+    printf("%10d %10.2f %10.0f\n", BENCH_JOBS, seconds,
+        BENCH_JOBS / seconds);
+    return 0;
+}
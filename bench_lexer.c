@@ -0,0 +1,62 @@
+/* Throughput of get_lex() on generated corpora,
+ * built and runned by `make bench`: as
+ * bench_lexer with table-driven lexer and as
+ * bench_lexer_sf with state functions one. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "lexer.h"
+#include "bench.h"
+
+int bench_lexer(bench_corpus corpus)
+{
+    lexer_info linfo;
+    lexeme lex;
+    unsigned long tokens = 0;
+    unsigned long lines = 0;
+    unsigned long bytes;
+    unsigned long allocs;
+    clock_t start;
+    double seconds;
+
+    bytes = bench_corpus_to_stdin(corpus);
+    if (bytes == 0)
+        return 1;
+
+    init_lexer(&linfo, STDIN_FILENO);
+    linfo.show_prompts = 0;
+    allocs = bench_allocs;
+    start = clock();
+
+    do {
+        get_lex(&linfo, &lex);
+        ++tokens;
+        if (lex.type == LEX_EOLINE)
+            ++lines;
+    } while (lex.type != LEX_EOFILE);
+
+    seconds = (double) (clock() - start) / CLOCKS_PER_SEC;
+    allocs = bench_allocs - allocs;
+    destroy_lexer(&linfo);
+
+    printf("%-12s %9.2f %11.2f %12.3f %10ld\n",
+        bench_corpus_name(corpus), bytes / seconds / 1e6,
+        tokens / seconds / 1e6, (double) allocs / lines,
+        bench_peak_rss());
+    return 0;
+}
+
+int main()
+{
+    return bench_run_all(
+#ifdef LEXER_STATE_FUNCTIONS
+        "Lexer: state functions\n"
+#else
+        "Lexer: table-driven\n"
+#endif
+        "corpus            MB/s   Mtokens/s  allocs/line  peak RSS KB",
+        bench_lexer);
+}
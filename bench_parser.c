@@ -0,0 +1,78 @@
+/* Throughput of parse_cmd_list() on generated
+ * corpora, built and runned by `make bench`.
+ * Each line parsed in its own arena, without
+ * plan cache and with it, as shell does. Hit
+ * of cache skips lexer and parser, so cached
+ * rows measure the cache, not parsing. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "parser.h"
+#include "bench.h"
+
+/* Run with plan cache */
+static int use_cache = 0;
+
+int bench_parser(bench_corpus corpus)
+{
+    parser_info pinfo;
+    plan_cache cache;
+    unsigned long trees = 0;
+    unsigned long lines = 0;
+    unsigned long bytes;
+    unsigned long allocs;
+    clock_t start;
+    double seconds;
+
+    bytes = bench_corpus_to_stdin(corpus);
+    if (bytes == 0)
+        return 1;
+
+    init_parser(&pinfo, STDIN_FILENO);
+    pinfo.linfo->show_prompts = 0;
+    new_plan_cache(&cache);
+    pinfo.cache = use_cache ? &cache : NULL;
+    allocs = bench_allocs;
+    start = clock();
+
+    do {
+        pinfo.arena = make_arena();
+        parse_cmd_list(&pinfo);
+        if (pinfo.error == 0)
+            ++trees;
+        ++lines;
+        release_arena(pinfo.arena);
+    } while (pinfo.cur_lex->type != LEX_EOFILE);
+
+    seconds = (double) (clock() - start) / CLOCKS_PER_SEC;
+    allocs = bench_allocs - allocs;
+    clear_plan_cache(&cache);
+    destroy_parser(&pinfo);
+
+    printf("%-12s %9.2f %11.3f %12.3f %10ld %9.1f\n",
+        bench_corpus_name(corpus), bytes / seconds / 1e6,
+        trees / seconds / 1e6, (double) allocs / lines,
+        bench_peak_rss(), 100.0 * cache.hits / lines);
+    return 0;
+}
+
+int main()
+{
+    int status;
+
+    status = bench_run_all(
+        "Parser: no plan cache\n"
+        "corpus            MB/s    Mtrees/s  allocs/line  peak RSS KB"
+        "  hits, %",
+        bench_parser);
+
+    use_cache = 1;
+    return bench_run_all(
+        "Parser: plan cache (hit skips lexer and parser)\n"
+        "corpus            MB/s    Mtrees/s  allocs/line  peak RSS KB"
+        "  hits, %",
+        bench_parser) || status;
+}
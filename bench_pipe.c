@@ -0,0 +1,136 @@
+/* Throughput and context switches of pipe
+ * between two processes for several capacities
+ * set by set_pipe_size(), as pipesize option
+ * does. Built and runned by `make bench`. */
+
+/* For fork() and getrusage() */
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include "launcher.h"
+#include "bench.h"
+
+/* Bytes passed through each pipe */
+#define BENCH_PIPE_TOTAL (256 * 1024 * 1024)
+
+/* Writes of writer, as cat does */
+#define BENCH_PIPE_WRITE (128 * 1024)
+
+#define BENCH_PIPE_READ (1024 * 1024)
+
+/* Capacities, 0 for default */
+static const unsigned long pipe_sizes[] = {
+    4096, 0, 256 * 1024, 1024 * 1024
+};
+
+#define COUNT(array) (sizeof(array) / sizeof(*(array)))
+
+long context_switches(int who)
+{
+    struct rusage usage;
+
+    if (getrusage(who, &usage) == -1)
+        return 0;
+    return usage.ru_nvcsw + usage.ru_nivcsw;
+}
+
+void write_all(int fd)
+{
+    static char buf[BENCH_PIPE_WRITE];
+    unsigned long left = BENCH_PIPE_TOTAL;
+    long res;
+
+    memset(buf, 'x', sizeof(buf));
+    while (left > 0) {
+        res = write(fd, buf, sizeof(buf));
+        if (res <= 0)
+            _exit(1);
+        left -= res;
+    }
+
+    _exit(0);
+}
+
+int bench_pipe(unsigned long size)
+{
+    static char buf[BENCH_PIPE_READ];
+    unsigned long total = 0;
+    struct timeval start, end;
+    long switches, child_switches;
+    double seconds;
+    int pipefd[2];
+    int status;
+    long res;
+    pid_t pid;
+
+    if (pipe(pipefd) == -1) {
+        perror("pipe()");
+        return 1;
+    }
+
+    if (size != 0 && set_pipe_size(pipefd[1], size) != 0) {
+        perror("set_pipe_size()");
+        return 1;
+    }
+
+    switches = context_switches(RUSAGE_SELF);
+    child_switches = context_switches(RUSAGE_CHILDREN);
+    gettimeofday(&start, NULL);
+
+    pid = fork();
+    if (pid == -1) {
+        perror("fork()");
+        return 1;
+    }
+    if (pid == 0) {
+        close(pipefd[0]);
+        write_all(pipefd[1]);
+    }
+
+    close(pipefd[1]);
+    while ((res = read(pipefd[0], buf, sizeof(buf))) > 0)
+        total += res;
+    close(pipefd[0]);
+
+    if (waitpid(pid, &status, 0) == -1 || total != BENCH_PIPE_TOTAL) {
+        fprintf(stderr, "%lu: bad writer\n", size);
+        return 1;
+    }
+
+    gettimeofday(&end, NULL);
+    seconds = (end.tv_sec - start.tv_sec)
+        + (end.tv_usec - start.tv_usec) / 1e6;
+    switches = context_switches(RUSAGE_SELF) - switches
+        + context_switches(RUSAGE_CHILDREN) - child_switches;
+
+    if (size == 0)
+        printf("%9s", "default");
+    else
+        printf("%9lu", size / 1024);
+    printf(" %10.1f %10.1f\n", total / seconds / 1024 / 1024,
+        (double) switches / (total / 1024 / 1024));
+    return 0;
+}
+
+int main()
+{
+    unsigned int i;
+
+    printf("Pipe\n");
+    printf("  pipe KB       MB/s  switch/MB\n");
+
+    for (i = 0; i < COUNT(pipe_sizes); ++i) {
+        if (bench_pipe(pipe_sizes[i]) != 0)
+            return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,96 @@
+/* Latency of launch_command() with fork and
+ * spawn methods, while RSS of shell grows.
+ * Built and runned by `make bench`. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+#include "launcher.h"
+#include "bench.h"
+
+/* Launches per method and size */
+#define BENCH_LAUNCHES 200
+
+/* Touched heap, megabytes */
+static const unsigned int heap_sizes[] = {
+    1, 64, 256, 1024
+};
+
+#define COUNT(array) (sizeof(array) / sizeof(*(array)))
+
+/* Returns microseconds per launch and wait
+ * of `true` or -1 on error */
+double bench_launch(launch_method method)
+{
+    static char *argv[] = { "true", NULL };
+    struct timeval start, end;
+    launch_info info;
+    unsigned int i;
+    int status;
+    pid_t pid;
+
+    info.argv = argv;
+    info.file = NULL;
+    info.job_control = 0;
+    info.pgid = 0;
+    info.tty = -1;
+    info.fd[0] = STDIN_FILENO;
+    info.fd[1] = STDOUT_FILENO;
+    info.close_fds = NULL;
+    info.count_close_fds = 0;
+
+    gettimeofday(&start, NULL);
+
+    for (i = 0; i < BENCH_LAUNCHES; ++i) {
+        pid = launch_command(method, &info);
+        if (pid == -1) {
+            perror("launch_command()");
+            return -1;
+        }
+        if (waitpid(pid, &status, 0) == -1
+            || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        {
+            fprintf(stderr, "%s: bad child\n", launch_method_name(method));
+            return -1;
+        }
+    }
+
+    gettimeofday(&end, NULL);
+    return ((end.tv_sec - start.tv_sec) * 1e6
+        + (end.tv_usec - start.tv_usec)) / BENCH_LAUNCHES;
+}
+
+int main()
+{
+    unsigned int i;
+    double fork_us, spawn_us;
+    char *heap;
+
+    printf("Launch\n");
+    printf(" heap MB    fork us   spawn us  peak RSS KB\n");
+
+    for (i = 0; i < COUNT(heap_sizes); ++i) {
+        /* Kept until exit, RSS only grows */
+        heap = (char *) malloc(heap_sizes[i] * 1024 * 1024);
+        if (heap == NULL) {
+            perror("malloc()");
+            return 1;
+        }
+        memset(heap, 1, heap_sizes[i] * 1024 * 1024);
+
+        fork_us = bench_launch(LAUNCH_FORK);
+        spawn_us = bench_launch(LAUNCH_SPAWN);
+        if (fork_us < 0 || spawn_us < 0)
+            return 1;
+
+        printf("%8u %10.1f %10.1f %12ld\n", heap_sizes[i],
+            fork_us, spawn_us, bench_peak_rss());
+    }
+
+    return 0;
+}
@@ -0,0 +1,81 @@
+/* Scaling of word_buffer: argv of 1, 10, 10k and
+ * 1M words built in arena, as parser does, and
+ * checked. Built and runned by `make bench`. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "word_buffer.h"
+#include "bench.h"
+
+/* Words added per size */
+#define BENCH_TOTAL_WORDS 10000000
+
+static const unsigned int count_words[] = {
+    1, 10, 10000, 1000000
+};
+
+static char *words[] = {
+    "ls", "-la", "file.txt", "/usr/share/doc", "x"
+};
+
+#define COUNT(array) (sizeof(array) / sizeof(*(array)))
+
+int bench_word_buffer(unsigned int count)
+{
+    unsigned int commands = BENCH_TOTAL_WORDS / count;
+    unsigned int i, j;
+    unsigned long allocs;
+    clock_t start;
+    double seconds;
+    word_buffer wbuf;
+    char **argv;
+    arena *a;
+
+    allocs = bench_allocs;
+    start = clock();
+
+    for (i = 0; i < commands; ++i) {
+        a = make_arena();
+        new_word_buffer(&wbuf, a);
+
+        for (j = 0; j < count; ++j)
+            add_to_word_buffer(&wbuf, words[j % COUNT(words)]);
+        argv = convert_to_argv(&wbuf, 1);
+
+        for (j = 0; j < count; ++j) {
+            if (argv[j] != words[j % COUNT(words)])
+                break;
+        }
+        if (j != count || argv[count] != NULL) {
+            fprintf(stderr, "%u words: bad argv[%u]\n", count, j);
+            return 1;
+        }
+
+        release_arena(a);
+    }
+
+    seconds = (double) (clock() - start) / CLOCKS_PER_SEC;
+    allocs = bench_allocs - allocs;
+
+    printf("%8u %10.2f %15.3f %12ld\n", count,
+        seconds * 1e9 / ((double) commands * count),
+        (double) allocs / commands, bench_peak_rss());
+    return 0;
+}
+
+int main()
+{
+    unsigned int i;
+
+    printf("Word buffer\n");
+    printf("   words    ns/word  allocs/command  peak RSS KB\n");
+
+    for (i = 0; i < COUNT(count_words); ++i) {
+        if (bench_word_buffer(count_words[i]) != 0)
+            return 1;
+    }
+
+    return 0;
+}
@@ -3,6 +3,94 @@
 
 #include "buffer.h"
 
+#ifdef BUFFER_ARRAY
+
+void new_buffer(buffer *buf)
+{
+/*  buffer *buf = (buffer *) malloc(sizeof(buffer)); */
+    buf->str = NULL;
+    buf->size = 0;
+    buf->count_sym = 0;
+}
+
+/* Make room for at least one more symbol.
+ * Size doubled, so adding is O(1) amortized. */
+void grow_buffer(buffer *buf)
+{
+    if (buf->size == 0)
+        buf->size = BUFFER_INITIAL_SIZE;
+    else
+        buf->size *= 2;
+
+    buf->str = (char *) realloc(buf->str, sizeof(char) * buf->size);
+}
+
+void add_to_buffer(buffer *buf, char c)
+{
+    if (buf->count_sym == buf->size)
+        grow_buffer(buf);
+
+    *(buf->str + buf->count_sym) = c;
+    ++(buf->count_sym);
+}
+
+/* Append len symbols by one copy */
+void add_chars_to_buffer(buffer *buf, const char *str, unsigned int len)
+{
+    while (buf->count_sym + len > buf->size)
+        grow_buffer(buf);
+
+    memcpy(buf->str + buf->count_sym, str, len);
+    buf->count_sym += len;
+}
+
+void clear_buffer(buffer *buf)
+{
+    if (buf->str != NULL)
+        free(buf->str);
+
+    buf->str = NULL;
+    buf->size = 0;
+    buf->count_sym = 0;
+}
+
+/* If destroy_me, storage handed over to
+ * caller without copying. */
+char *convert_to_string(buffer *buf, int destroy_me)
+{
+    char *str;
+
+    if (destroy_me) {
+        /* Room for '\0' */
+        if (buf->count_sym == buf->size)
+            grow_buffer(buf);
+        str = buf->str;
+        buf->str = NULL;
+        buf->size = 0;
+    } else {
+        str = (char *) malloc(sizeof(char) * (buf->count_sym + 1));
+        if (buf->count_sym != 0)
+            memcpy(str, buf->str, buf->count_sym);
+    }
+
+    *(str + buf->count_sym) = '\0';
+
+    if (destroy_me)
+        buf->count_sym = 0;
+
+    return str;
+}
+
+/* Returns -1, if buffer empty */
+int get_last_from_buffer(buffer *buf)
+{
+    if (buf->count_sym == 0)
+        return -1;
+    return *(buf->str + buf->count_sym - 1);
+}
+
+#else
+
 void new_buffer(buffer *buf)
 {
 /*  buffer *buf = (buffer *) malloc(sizeof(buffer)); */
@@ -33,6 +121,14 @@ void add_to_buffer(buffer *buf, char c)
     ++(buf->count_sym);
 }
 
+void add_chars_to_buffer(buffer *buf, const char *str, unsigned int len)
+{
+    unsigned int i;
+
+    for (i = 0; i < len; ++i)
+        add_to_buffer(buf, str[i]);
+}
+
 void clear_buffer(buffer *buf)
 {
     strblock *current = buf->first_block;
@@ -91,6 +187,8 @@ int get_last_from_buffer(buffer *buf)
             ((buf->count_sym - 1) % BUFFER_BLOCK_SIZE));
 }
 
+#endif
+
 /*
 gcc -g -Wall -ansi -pedantic buffer.c -o buffer
 */
@@ -1,6 +1,26 @@
 #ifndef BUFFER_H_SENTRY
 #define BUFFER_H_SENTRY
 
+/* With BUFFER_ARRAY (see DEFINE in Makefile)
+ * buffer is one growable array, otherwise it
+ * is list of blocks. */
+
+#ifdef BUFFER_ARRAY
+
+/* Size of first allocation,
+ * it doubled on each growth. */
+#ifndef BUFFER_INITIAL_SIZE
+#define BUFFER_INITIAL_SIZE 16
+#endif
+
+typedef struct buffer {
+    char *str;
+    unsigned int size;
+    unsigned int count_sym;
+} buffer;
+
+#else
+
 #ifndef BUFFER_BLOCK_SIZE
 #define BUFFER_BLOCK_SIZE 8
 #endif
@@ -16,8 +36,11 @@ typedef struct buffer {
     unsigned int count_sym;
 } buffer;
 
+#endif
+
 void new_buffer(buffer *buf);
 void add_to_buffer(buffer *buf, char c);
+void add_chars_to_buffer(buffer *buf, const char *str, unsigned int len);
 void clear_buffer(buffer *buf);
 char *convert_to_string(buffer *buf, int destroy_me);
 int get_last_from_buffer(buffer *buf);
@@ -0,0 +1,40 @@
+buffer.o: buffer.c buffer.h
+input.o: input.c input.h scan.h
+scan.o: scan.c scan.h
+arena.o: arena.c arena.h input.h
+lexer.o: lexer.c lexer.h input.h utils.h runner.h parser.h arena.h \
+ plan_cache.h buffer.h word_buffer.h launcher.h path_cache.h
+word_buffer.o: word_buffer.c word_buffer.h arena.h input.h
+plan_cache.o: plan_cache.c plan_cache.h arena.h input.h
+parser.o: parser.c parser.h lexer.h input.h arena.h plan_cache.h \
+ word_buffer.h utils.h runner.h buffer.h launcher.h path_cache.h
+path_cache.o: path_cache.c path_cache.h utils.h runner.h parser.h lexer.h \
+ input.h arena.h plan_cache.h buffer.h word_buffer.h launcher.h
+launcher.o: launcher.c utils.h runner.h parser.h lexer.h input.h arena.h \
+ plan_cache.h buffer.h word_buffer.h launcher.h path_cache.h
+runner.o: runner.c runner.h parser.h lexer.h input.h arena.h plan_cache.h \
+ buffer.h word_buffer.h launcher.h path_cache.h utils.h utility.h
+utility.o: utility.c utility.h runner.h parser.h lexer.h input.h arena.h \
+ plan_cache.h buffer.h word_buffer.h launcher.h path_cache.h utils.h
+utils.o: utils.c utils.h runner.h parser.h lexer.h input.h arena.h \
+ plan_cache.h buffer.h word_buffer.h launcher.h path_cache.h
+main.o: main.c main.h runner.h parser.h lexer.h input.h arena.h \
+ plan_cache.h buffer.h word_buffer.h launcher.h path_cache.h utils.h
+buffer.o: buffer.h
+input.o: input.h
+scan.o: scan.h
+arena.o: arena.h input.h
+lexer.o: lexer.h input.h
+word_buffer.o: word_buffer.h arena.h input.h
+plan_cache.o: plan_cache.h arena.h input.h
+parser.o: parser.h lexer.h input.h arena.h plan_cache.h
+path_cache.o: path_cache.h
+launcher.o: launcher.h
+runner.o: runner.h parser.h lexer.h input.h arena.h plan_cache.h buffer.h \
+ word_buffer.h launcher.h path_cache.h utils.h runner.h
+utility.o: utility.h runner.h parser.h lexer.h input.h arena.h \
+ plan_cache.h buffer.h word_buffer.h launcher.h path_cache.h utils.h
+utils.o: utils.h runner.h parser.h lexer.h input.h arena.h plan_cache.h \
+ buffer.h word_buffer.h launcher.h path_cache.h utils.h
+main.o: main.h runner.h parser.h lexer.h input.h arena.h plan_cache.h \
+ buffer.h word_buffer.h launcher.h path_cache.h utils.h
@@ -0,0 +1,387 @@
+/* For MAP_ANONYMOUS */
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <limits.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <poll.h>
+
+#include "input.h"
+#include "scan.h"
+
+/* Read as much as possible. Terminal in canonical
+ * mode gives us one line per read(2), so interactive
+ * input still goes line by line. */
+int fill_block(input_source *src)
+{
+    struct pollfd fds[2];
+    int res;
+
+    /* Prompt must be visible before blocking */
+    fflush(stdout);
+
+    /* Events handled while input not ready */
+    while (src->event_fd != -1) {
+        fds[0].fd = src->fd;
+        fds[0].events = POLLIN;
+        fds[1].fd = src->event_fd;
+        fds[1].events = POLLIN;
+
+        res = poll(fds, 2, -1);
+        if (res == -1 && errno == EINTR)
+            continue;
+        /* read() reports error */
+        if (res == -1 || fds[0].revents != 0)
+            break;
+
+        src->on_event(src->event_data);
+        fflush(stdout);
+    }
+
+    do {
+        res = read(src->fd, src->buf + src->len,
+            src->size - src->len);
+    } while (res == -1 && errno == EINTR);
+
+    return res;
+}
+
+input_block *make_input_block(unsigned int size)
+{
+    input_block *block =
+        (input_block *) malloc(sizeof(input_block));
+    block->refs = 1;
+    block->size = size;
+    block->prev = NULL;
+    block->data = (char *) malloc(sizeof(char) * (size + 1));
+    block->mapped = 0;
+    return block;
+}
+
+void unref_input_block(input_block *block)
+{
+    if (--(block->refs) > 0)
+        return;
+
+    if (block->mapped)
+        munmap(block->data, block->size + 1);
+    else
+        free(block->data);
+    free(block);
+}
+
+void set_input_block(input_source *src, input_block *block)
+{
+    src->block = block;
+    src->buf = block->data;
+    src->size = block->size;
+}
+
+/* Whole input (mapped file or
+ * command string) already in block */
+int fill_none(input_source *src)
+{
+    return 0;
+}
+
+/* Position at begin of block with len bytes */
+void start_input(input_source *src, unsigned int len, int eof)
+{
+    src->pos = 0;
+    src->len = len;
+    src->line = NULL;
+    src->line_start = 0;
+    src->word_start = 0;
+    src->wpos = 0;
+    src->in_word = 0;
+    src->eof = eof;
+    src->event_fd = -1;
+    src->on_event = NULL;
+    src->event_data = NULL;
+}
+
+void new_fd_input(input_source *src, int fd)
+{
+/*  input_source *src =
+        (input_source *) malloc(sizeof(input_source)); */
+
+    src->fd = fd;
+    src->block_size = isatty(fd) ? INPUT_LINE_SIZE : INPUT_BLOCK_SIZE;
+    src->fill = fill_block;
+    set_input_block(src, make_input_block(src->block_size));
+    start_input(src, 0, 0);
+}
+
+/* Command string (shell -c) copied to one
+ * block, so it can be unescaped in place. */
+void new_str_input(input_source *src, const char *str)
+{
+    unsigned int len = strlen(str);
+
+    src->fd = -1;
+    src->block_size = len;
+    src->fill = fill_none;
+    set_input_block(src, make_input_block(len));
+    memcpy(src->buf, str, len);
+    /* Nothing to read, buffer never switched */
+    start_input(src, len, 1);
+}
+
+/* Map regular file as one block. Mapping is
+ * private and writable, because words unescaped
+ * in place. Anonymous mapping gives one more
+ * byte for '\0' after end of file.
+ * Returns:
+ * 0, on success (fd closed);
+ * -1, if file can not be mapped (not regular
+ * file, too large, mmap error), then caller
+ * should read it by new_fd_input(). */
+int new_mmap_input(input_source *src, int fd)
+{
+    struct stat st;
+    unsigned int size;
+    char *data;
+    input_block *block;
+
+    if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode)
+        || st.st_size >= UINT_MAX)
+    {
+        return -1;
+    }
+    size = st.st_size;
+
+    data = mmap(NULL, size + 1, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (data == MAP_FAILED)
+        return -1;
+
+    if (size > 0 && mmap(data, size, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED)
+    {
+        munmap(data, size + 1);
+        return -1;
+    }
+
+    block = (input_block *) malloc(sizeof(input_block));
+    block->refs = 1;
+    block->size = size;
+    block->prev = NULL;
+    block->data = data;
+    block->mapped = 1;
+
+    close(fd);
+    src->fd = -1;
+    src->block_size = size;
+    src->fill = fill_none;
+    set_input_block(src, block);
+    /* Nothing to read, buffer never switched */
+    start_input(src, size, 1);
+
+    return 0;
+}
+
+void destroy_input(input_source *src)
+{
+    if (src->line != NULL)
+        release_input_line(input_line_end(src));
+    unref_input_block(src->block);
+    src->block = NULL;
+    src->buf = NULL;
+    src->pos = src->len = src->size = 0;
+}
+
+/* Make room after src->len. Symbols from begin
+ * of current line (or word) keep contiguous:
+ * they moved to begin of block, if nobody refer
+ * to block, or copied to new block otherwise. */
+void switch_input_block(input_source *src)
+{
+    unsigned int keep = src->len;
+    unsigned int keep_len;
+    input_block *block;
+
+    if (src->line != NULL)
+        keep = src->line_start;
+    /* Lexer may start line with already readed
+     * symbol, so word can begin before line */
+    if (src->in_word && src->word_start < keep)
+        keep = src->word_start;
+    keep_len = src->len - keep;
+
+    if (src->block->refs == 1 && keep_len <= src->size / 2) {
+        memmove(src->buf, src->buf + keep, keep_len);
+    } else {
+        block = make_input_block((keep_len < src->block_size / 2) ?
+            src->block_size : keep_len * 2);
+        memcpy(block->data, src->buf + keep, keep_len);
+        block->prev = src->block;
+
+        if (src->line != NULL) {
+            ++(block->refs);
+            src->line->last_block = block;
+            ++(src->line->count_blocks);
+        }
+
+        unref_input_block(src->block);
+        set_input_block(src, block);
+    }
+
+    src->pos -= keep;
+    src->len = keep_len;
+    src->line_start -= (src->line != NULL) ? keep : 0;
+    if (src->in_word) {
+        src->word_start -= keep;
+        src->wpos -= keep;
+    }
+}
+
+/* Read next portion after src->len.
+ * Returns count of readed bytes or 0 on
+ * end of file. EOF is sticky like in stdio. */
+int input_read_more(input_source *src)
+{
+    int res;
+
+    if (src->eof)
+        return 0;
+
+    if (src->len == src->size)
+        switch_input_block(src);
+
+    res = src->fill(src);
+
+    if (res == -1)
+        perror("read()");
+
+    if (res <= 0) {
+        src->eof = 1;
+        return 0;
+    }
+
+    src->len += res;
+    return res;
+}
+
+/* Called by INPUT_GETC() if buffer is empty.
+ * Returns next symbol or EOF. */
+int input_fill(input_source *src)
+{
+    if (input_read_more(src) == 0)
+        return EOF;
+
+    return (unsigned char) *(src->buf + (src->pos)++);
+}
+
+/* Read input until '\n' from current position
+ * in buffer, but not consume it. Line must be
+ * retained (see input_line_begin()), so it kept
+ * in buffer. Returns pointer to line (valid
+ * until next read) and its length with '\n',
+ * or NULL, if input ended before '\n'. */
+const char *input_peek_line(input_source *src, unsigned int *len)
+{
+    unsigned int searched = 0;
+    char *eol;
+
+    while ((eol = memchr(src->buf + src->pos + searched, '\n',
+        src->len - src->pos - searched)) == NULL)
+    {
+        searched = src->len - src->pos;
+        if (input_read_more(src) == 0)
+            return NULL;
+    }
+
+    *len = eol - (src->buf + src->pos) + 1;
+    return src->buf + src->pos;
+}
+
+/* Retain blocks from current position
+ * until input_line_end(). */
+void input_line_begin(input_source *src)
+{
+    input_line *line = (input_line *) malloc(sizeof(input_line));
+    line->refs = 1;
+    line->last_block = src->block;
+    line->count_blocks = 1;
+    ++(src->block->refs);
+
+    src->line = line;
+    src->line_start = src->pos;
+}
+
+/* Returns retained line, caller
+ * must release it. */
+input_line *input_line_end(input_source *src)
+{
+    input_line *line = src->line;
+    src->line = NULL;
+    return line;
+}
+
+void ref_input_line(input_line *line)
+{
+    ++(line->refs);
+}
+
+void release_input_line(input_line *line)
+{
+    input_block *block;
+    input_block *prev;
+
+    if (line == NULL || --(line->refs) > 0)
+        return;
+
+    block = line->last_block;
+    while (line->count_blocks > 0) {
+        prev = block->prev;
+        unref_input_block(block);
+        block = prev;
+        --(line->count_blocks);
+    }
+
+    free(line);
+}
+
+/* Word starts from last readed symbol. */
+void input_word_begin(input_source *src)
+{
+    src->word_start = src->wpos = src->pos - 1;
+    src->in_word = 1;
+}
+
+/* Append to word all plain symbols, which
+ * already in buffer. They moved only if word
+ * unescaped before, otherwise stay in place. */
+void input_word_run(input_source *src)
+{
+    unsigned int run =
+        scan_word_run(src->buf + src->pos, src->len - src->pos);
+
+    if (src->wpos != src->pos)
+        memmove(src->buf + src->wpos, src->buf + src->pos, run);
+
+    src->pos += run;
+    src->wpos += run;
+}
+
+/* Terminate word by '\0' and return it.
+ * Terminating symbol already readed, so
+ * overwriting is safe. Pointer is valid
+ * while block retained. */
+char *input_word_end(input_source *src)
+{
+    *(src->buf + src->wpos) = '\0';
+    src->in_word = 0;
+    return src->buf + src->word_start;
+}
+
+void input_word_cancel(input_source *src)
+{
+    src->in_word = 0;
+}
@@ -0,0 +1,103 @@
+#ifndef INPUT_H_SENTRY
+#define INPUT_H_SENTRY
+
+/* Size of block for read(2) from files and pipes. */
+#ifndef INPUT_BLOCK_SIZE
+#define INPUT_BLOCK_SIZE 65536
+#endif
+
+/* Size of block for terminal. Terminal in
+ * canonical mode returns at most one line
+ * per read(2), so it is not a limit for line. */
+#ifndef INPUT_LINE_SIZE
+#define INPUT_LINE_SIZE 4096
+#endif
+
+/* Readed data. Words of command lines
+ * point to it, so block freed only when
+ * nobody refer to it. */
+typedef struct input_block {
+    int refs;
+    unsigned int size;
+    /* Previous block of the same input.
+     * Not owned, see input_line. */
+    struct input_block *prev;
+    /* size + 1 bytes, last for '\0' */
+    char *data;
+    /* data is private mapping of file */
+    unsigned int mapped:1;
+} input_block;
+
+/* Retained command line: keeps all blocks
+ * with its words. Line, which not fitted in
+ * one block, copied to next block, so blocks
+ * of line are last_block and count_blocks - 1
+ * blocks before it (via prev). */
+typedef struct input_line {
+    int refs;
+    input_block *last_block;
+    unsigned int count_blocks;
+} input_line;
+
+typedef struct input_source {
+    int fd;
+    input_block *block;
+    char *buf; /* block->data */
+    unsigned int size; /* block->size */
+    unsigned int pos;
+    unsigned int len;
+    /* Size of new blocks */
+    unsigned int block_size;
+    /* Read next portion to buf + len.
+     * Returns:
+     * count of readed bytes;
+     * 0, on end of file;
+     * -1, on error. */
+    int (*fill)(struct input_source *src);
+    /* Current line, NULL if not retained */
+    input_line *line;
+    unsigned int line_start;
+    /* Word, which unescaped in place */
+    unsigned int word_start;
+    unsigned int wpos;
+    unsigned int in_word:1;
+    unsigned int eof:1;
+    /* If not -1, fill_block() waits for it too
+     * and calls on_event(event_data), when it
+     * readable (SIGCHLD at prompt, see main) */
+    int event_fd;
+    void (*on_event)(void *data);
+    void *event_data;
+} input_source;
+
+void new_fd_input(input_source *src, int fd);
+int new_mmap_input(input_source *src, int fd);
+void new_str_input(input_source *src, const char *str);
+void destroy_input(input_source *src);
+int input_read_more(input_source *src);
+int input_fill(input_source *src);
+const char *input_peek_line(input_source *src, unsigned int *len);
+
+void input_line_begin(input_source *src);
+input_line *input_line_end(input_source *src);
+void ref_input_line(input_line *line);
+void release_input_line(input_line *line);
+
+void input_word_begin(input_source *src);
+void input_word_run(input_source *src);
+char *input_word_end(input_source *src);
+void input_word_cancel(input_source *src);
+
+/* Returns next symbol as unsigned char
+ * or EOF. Refill buffer only if it empty. */
+#define INPUT_GETC(src) (((src)->pos < (src)->len) ? \
+    (unsigned char) (src)->buf[((src)->pos)++] : \
+    input_fill(src))
+
+/* Append symbol to current word. Unescaped word
+ * never longer than its source, so it written
+ * over already readed symbols. */
+#define INPUT_WORD_PUT(src, c) \
+    ((src)->buf[((src)->wpos)++] = (c))
+
+#endif
@@ -0,0 +1,307 @@
+/* For posix_spawn_file_actions_addtcsetpgrp_np() and environ */
+#define _GNU_SOURCE
+
+#include "utils.h"
+
+#include <signal.h>
+#include <spawn.h>
+#include <limits.h>
+#include <errno.h>
+
+/* Child after fork(): set process group ID,
+ * controlling terminal and job control signals
+ * to SIG_DFL, install standard channels (tty
+ * could be replaced) */
+void prepare_process(launch_info *info)
+{
+    unsigned int i;
+
+    if (info->job_control) {
+        /* set process group ID
+         * we must make it before tcsetpgrp */
+        if (SETPGID_ERROR(setpgid(0, info->pgid))) {
+            perror("(In child process) setpgid");
+            exit(ES_SYSCALL_FAILED);
+        }
+
+        /* we must make in before execvp */
+        if (info->tty != -1
+            && TCSETPGRP_ERROR(tcsetpgrp(info->tty, getpgrp())))
+        {
+            perror("(In child process) tcsetpgrp()");
+            exit(ES_SYSCALL_FAILED);
+        }
+
+        set_sig_dfl();
+    }
+
+    if ((info->fd[0] != STDIN_FILENO
+        && DUP2_ERROR(dup2(info->fd[0], STDIN_FILENO)))
+        || (info->fd[1] != STDOUT_FILENO
+        && DUP2_ERROR(dup2(info->fd[1], STDOUT_FILENO))))
+    {
+        perror("(In child process) dup2");
+        exit(ES_SYSCALL_FAILED);
+    }
+
+    /* Error is not fatal: close on exec */
+    for (i = 0; i < info->count_close_fds; ++i) {
+        if (info->close_fds[i] > STDERR_FILENO)
+            close(info->close_fds[i]);
+    }
+}
+
+/* Exec of prepared child => no return */
+void launch_process(launch_info *info)
+{
+    int status;
+
+    if (info->file != NULL) {
+        execv(info->file, info->argv);
+        /* execvp() runs script without #! by /bin/sh */
+        if (errno != ENOEXEC) {
+            status = EXEC_ERROR_STATUS(errno);
+            perror("(In child process) execv");
+            exit(status);
+        }
+    }
+
+    execvp(*(info->argv), info->argv);
+    status = EXEC_ERROR_STATUS(errno);
+    perror("(In child process) execvp");
+    exit(status);
+}
+
+/* Child prepared as for command, but runs
+ * code of shell (info->argv not used).
+ * Returns:
+ * 0, in child;
+ * pid of child, in shell;
+ * -1, on error. */
+pid_t launch_shell(launch_info *info)
+{
+    pid_t pid = fork();
+
+    if (FORK_IS_CHILD(pid)) {
+        prepare_process(info);
+        return 0;
+    }
+
+    if (FORK_ERROR(pid))
+        return -1;
+
+    /* Same in parent: we must make it before
+     * tcsetpgrp for job. EACCES means child
+     * already made it and exec'ed. */
+    if (info->job_control
+        && SETPGID_ERROR(setpgid(pid, info->pgid == 0 ? pid : info->pgid))
+        && errno != EACCES)
+    {
+        perror("setpgid");
+        exit(ES_SYSCALL_FAILED);
+    }
+
+    return pid;
+}
+
+/* Errors of exec reported by child */
+pid_t launch_fork(launch_info *info)
+{
+    pid_t pid = launch_shell(info);
+
+    if (FORK_IS_CHILD(pid)) {
+        launch_process(info);
+        /* No return */
+    }
+
+    return pid;
+}
+
+/* As execvp() does: file without #!
+ * runned by /bin/sh. Returns error of
+ * posix_spawn(). */
+int spawn_script(pid_t *pid, const char *file,
+    posix_spawn_file_actions_t *actions, posix_spawnattr_t *attr,
+    char **argv)
+{
+    unsigned int count = 0;
+    char **sh_argv;
+    int error;
+
+    while (argv[count] != NULL)
+        ++count;
+
+    sh_argv = (char **) malloc(sizeof(char *) * (count + 2));
+    sh_argv[0] = "sh";
+    sh_argv[1] = (char *) file;
+    memcpy(sh_argv + 2, argv + 1, sizeof(char *) * count);
+
+    error = posix_spawn(pid, "/bin/sh", actions, attr, sh_argv, environ);
+    free(sh_argv);
+    return error;
+}
+
+/* Child shares memory with shell until exec
+ * (clone with CLONE_VM | CLONE_VFORK in glibc),
+ * so cost does not grow with shell RSS. Errors
+ * of exec reported here, no process left. */
+pid_t launch_spawn(launch_info *info)
+{
+    posix_spawnattr_t attr;
+    posix_spawn_file_actions_t actions;
+    sigset_t sig_dfl;
+    pid_t pid;
+    int error;
+
+    posix_spawnattr_init(&attr);
+    posix_spawn_file_actions_init(&actions);
+
+    if (info->job_control) {
+        posix_spawnattr_setpgroup(&attr, info->pgid);
+
+        /* Same as set_sig_dfl() */
+        sigemptyset(&sig_dfl);
+        sigaddset(&sig_dfl, SIGINT);
+        sigaddset(&sig_dfl, SIGQUIT);
+        sigaddset(&sig_dfl, SIGTSTP);
+        sigaddset(&sig_dfl, SIGTTIN);
+        sigaddset(&sig_dfl, SIGTTOU);
+        posix_spawnattr_setsigdefault(&attr, &sig_dfl);
+
+        posix_spawnattr_setflags(&attr,
+            POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGDEF);
+
+        /* Signals blocked in child until exec,
+         * so no SIGTTOU from background group */
+        if (info->tty != -1)
+            posix_spawn_file_actions_addtcsetpgrp_np(&actions, info->tty);
+    }
+
+    /* Other descriptors of job are closed on exec */
+    if (info->fd[0] != STDIN_FILENO)
+        posix_spawn_file_actions_adddup2(&actions, info->fd[0],
+            STDIN_FILENO);
+    if (info->fd[1] != STDOUT_FILENO)
+        posix_spawn_file_actions_adddup2(&actions, info->fd[1],
+            STDOUT_FILENO);
+
+    if (info->file != NULL)
+        error = posix_spawn(&pid, info->file, &actions, &attr,
+            info->argv, environ);
+    else
+        error = posix_spawnp(&pid, *(info->argv), &actions, &attr,
+            info->argv, environ);
+
+    if (error == ENOEXEC && info->file != NULL)
+        error = spawn_script(&pid, info->file, &actions, &attr, info->argv);
+
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attr);
+
+    if (error != 0) {
+        errno = error;
+        return -1;
+    }
+
+    return pid;
+}
+
+/* Returns:
+ * pid of child process;
+ * -1 with errno set, if process not created. */
+pid_t launch_command(launch_method method, launch_info *info)
+{
+    if (method == LAUNCH_SPAWN)
+        return launch_spawn(info);
+    return launch_fork(info);
+}
+
+static const char *launch_method_names[] = { "fork", "spawn" };
+
+const char *launch_method_name(launch_method method)
+{
+    return launch_method_names[method];
+}
+
+/* Returns method or -1, if name unknown */
+int launch_method_by_name(const char *name)
+{
+    if (STR_EQUAL(name, launch_method_names[LAUNCH_FORK]))
+        return LAUNCH_FORK;
+    if (STR_EQUAL(name, launch_method_names[LAUNCH_SPAWN]))
+        return LAUNCH_SPAWN;
+    return -1;
+}
+
+/* Limit of pipe capacity, read on first use
+ * of max_pipe_size() */
+static unsigned long pipe_size_limit = 0;
+
+/* Returns limit of pipe capacity, INT_MAX
+ * (limit of F_SETPIPE_SZ argument), if limit
+ * of system unknown */
+unsigned long max_pipe_size(void)
+{
+    FILE *f;
+
+    if (pipe_size_limit != 0)
+        return pipe_size_limit;
+
+    f = fopen(PIPE_MAX_SIZE_FILE, "r");
+    if (f != NULL) {
+        if (fscanf(f, "%lu", &pipe_size_limit) != 1)
+            pipe_size_limit = 0;
+        fclose(f);
+    }
+
+    if (pipe_size_limit == 0 || pipe_size_limit > INT_MAX)
+        pipe_size_limit = INT_MAX;
+    return pipe_size_limit;
+}
+
+/* Size in bytes with optional K or M suffix,
+ * limited by max_pipe_size().
+ * Returns:
+ * 0, on success;
+ * -1, if str is not a size or too big. */
+int parse_pipe_size(const char *str, unsigned long *size)
+{
+    unsigned long unit = 1;
+    char *end;
+
+    if (*str < '0' || *str > '9')
+        return -1;
+
+    errno = 0;
+    *size = strtoul(str, &end, 10);
+    if (errno == ERANGE)
+        return -1;
+
+    if (*end == 'K' || *end == 'k') {
+        unit = 1024;
+        ++end;
+    } else if (*end == 'M' || *end == 'm') {
+        unit = 1024 * 1024;
+        ++end;
+    }
+
+    if (*end != '\0' || *size == 0 || *size > ULONG_MAX / unit)
+        return -1;
+
+    *size *= unit;
+    if (*size > max_pipe_size())
+        *size = max_pipe_size();
+    return 0;
+}
+
+/* Set capacity of pipe, kernel rounds
+ * it up to power of two pages.
+ * Returns:
+ * 0, on success;
+ * -1, otherwise. */
+int set_pipe_size(int fd, unsigned long size)
+{
+    if (size > INT_MAX)
+        size = INT_MAX;
+    return (fcntl(fd, F_SETPIPE_SZ, (int) size) == -1) ? -1 : 0;
+}
@@ -0,0 +1,49 @@
+#ifndef LAUNCHER_H_SENTRY
+#define LAUNCHER_H_SENTRY
+
+#include <sys/types.h>
+
+/* How process of external command created */
+typedef enum launch_method {
+    LAUNCH_FORK,  /* fork(), child sets itself up and execs */
+    LAUNCH_SPAWN  /* posix_spawnp(), shell memory not copied */
+} launch_method;
+
+/* All that child must do before exec */
+typedef struct launch_info {
+    char **argv;
+    /* Resolved file of argv[0] (see path_cache)
+     * or NULL to search it in PATH */
+    const char *file;
+    unsigned int job_control:1;
+    /* If job_control: process group to join
+     * or 0 for new group of the process */
+    pid_t pgid;
+    /* If job_control: terminal to give to the
+     * process group (foreground job) or -1 */
+    int tty;
+    /* Standard input and output of child,
+     * installed by dup2() */
+    int fd[2];
+    /* Other descriptors of job to close in
+     * child (-1 skipped), only them: shell may
+     * have its own ones. All of them are close
+     * on exec too. */
+    const int *close_fds;
+    unsigned int count_close_fds;
+} launch_info;
+
+/* Limit for unprivileged F_SETPIPE_SZ */
+#define PIPE_MAX_SIZE_FILE "/proc/sys/fs/pipe-max-size"
+
+pid_t launch_command(launch_method method, launch_info *info);
+pid_t launch_shell(launch_info *info);
+void prepare_process(launch_info *info);
+void launch_process(launch_info *info);
+const char *launch_method_name(launch_method method);
+int launch_method_by_name(const char *name);
+unsigned long max_pipe_size(void);
+int parse_pipe_size(const char *str, unsigned long *size);
+int set_pipe_size(int fd, unsigned long size);
+
+#endif
@@ -1,8 +1,11 @@
 #include <stdlib.h>
+#include <unistd.h>
 
 #include "lexer.h"
-#include "buffer.h"
 #include "utils.h"
+#ifdef LEXER_STATE_FUNCTIONS
+#include "buffer.h"
+#endif
 
 void print_state(const char *state_name, int c)
 {
@@ -80,33 +83,73 @@ void deferred_get_char(lexer_info *linfo)
 
 void get_char(lexer_info *linfo)
 {
-    linfo->c = getchar();
+    linfo->c = INPUT_GETC(&linfo->input);
 }
 
-void init_lexer(lexer_info *linfo)
+/* Script file (fd is not stdin) mapped to
+ * memory and readed without prompts. Stdin,
+ * pipes and special files readed by blocks. */
+void init_lexer(lexer_info *linfo, int fd)
 {
 /*  lexer_info *linfo =
         (lexer_info *) malloc(sizeof(lexer_info)); */
 
     deferred_get_char(linfo);
     linfo->state = ST_START;
+    linfo->show_prompts = (fd == STDIN_FILENO);
+    linfo->blank = 0;
+    if (fd == STDIN_FILENO || new_mmap_input(&linfo->input, fd) != 0)
+        new_fd_input(&linfo->input, fd);
+    linfo->lex = NULL;
+}
+
+/* Returns 1, if lexer stands on begin of
+ * line and has no readed symbols. */
+int lexer_at_line_start(lexer_info *linfo)
+{
+    return linfo->get_next_char && linfo->state == ST_START;
+}
+
+/* Skip len symbols of input, which lexer
+ * not need (command line parsed before). */
+void lexer_skip(lexer_info *linfo, unsigned int len)
+{
+    linfo->input.pos += len;
+    linfo->state = ST_START;
+    deferred_get_char(linfo);
 }
 
-lexeme *make_lex(type_of_lex type)
+void destroy_lexer(lexer_info *linfo)
 {
-    lexeme *lex = (lexeme *) malloc(sizeof(lexeme));
+    destroy_input(&linfo->input);
+    linfo->lex = NULL;
+}
+
+/* Command string given by -c option */
+void init_lexer_str(lexer_info *linfo, const char *str)
+{
+    deferred_get_char(linfo);
+    linfo->state = ST_START;
+    linfo->show_prompts = 0;
+    linfo->blank = 0;
+    new_str_input(&linfo->input, str);
+    linfo->lex = NULL;
+}
+
+/* Fill record given to get_lex(),
+ * its word points to input. */
+lexeme *make_lex(lexer_info *linfo, type_of_lex type)
+{
+    lexeme *lex = linfo->lex;
 /*    lex->next = NULL; */
     lex->type = type;
     lex->str = NULL;
+    lex->joined = !linfo->blank;
+    linfo->blank = 0;
     return lex;
 }
 
-void destroy_lex(lexeme *lex)
-{
-    if (lex->str != NULL)
-        free(lex->str);
-    free(lex);
-}
+#ifdef LEXER_STATE_FUNCTIONS
 
 lexeme *st_start(lexer_info *linfo, buffer *buf)
 {
@@ -121,6 +164,7 @@ lexeme *st_start(lexer_info *linfo, buffer *buf)
         break;
     case ' ':
     case '\t':
+        linfo->blank = 1;
         deferred_get_char(linfo);
         break;
     case '<':
@@ -138,6 +182,7 @@ lexeme *st_start(lexer_info *linfo, buffer *buf)
     case '\\':
     case '\"':
     default:
+        input_word_begin(&linfo->input);
         linfo->state = ST_WORD;
         break;
     }
@@ -155,19 +200,19 @@ lexeme *st_one_sym_lex(lexer_info *linfo, buffer *buf)
 
     switch (linfo->c) {
     case '<':
-        lex = make_lex(LEX_INPUT);
+        lex = make_lex(linfo, LEX_INPUT);
         break;
     case ';':
-        lex = make_lex(LEX_SEMICOLON);
+        lex = make_lex(linfo, LEX_SEMICOLON);
         break;
     case '(':
-        lex = make_lex(LEX_BRACKET_OPEN);
+        lex = make_lex(linfo, LEX_BRACKET_OPEN);
         break;
     case ')':
-        lex = make_lex(LEX_BRACKET_CLOSE);
+        lex = make_lex(linfo, LEX_BRACKET_CLOSE);
         break;
     case '`':
-        lex = make_lex(LEX_REVERSE);
+        lex = make_lex(linfo, LEX_REVERSE);
         break;
     default:
         fprintf(stderr, "Lexer: error in ST_ONE_SYM_LEX;");
@@ -199,18 +244,18 @@ lexeme *st_one_two_sym_lex(lexer_info *linfo, buffer *buf)
         switch (prev_c) {
         case '>':
             lex = (prev_c == linfo->c) ?
-                make_lex(LEX_APPEND) :
-                make_lex(LEX_OUTPUT);
+                make_lex(linfo, LEX_APPEND) :
+                make_lex(linfo, LEX_OUTPUT);
             break;
         case '|':
             lex = (prev_c == linfo->c) ?
-                make_lex(LEX_OR) :
-                make_lex(LEX_PIPE);
+                make_lex(linfo, LEX_OR) :
+                make_lex(linfo, LEX_PIPE);
             break;
         case '&':
             lex = (prev_c == linfo->c) ?
-                make_lex(LEX_AND) :
-                make_lex(LEX_BACKGROUND);
+                make_lex(linfo, LEX_AND) :
+                make_lex(linfo, LEX_BACKGROUND);
             break;
         default:
             fprintf(stderr, "Lexer: error (type 1) in ST_ONE_TWO_SYM_LEX;");
@@ -242,33 +287,34 @@ lexeme *st_backslash(lexer_info *linfo, buffer *buf)
         return NULL;
     case '\n':
         /* Ignore newline symbol */
-        print_prompt2();
+        if (linfo->show_prompts)
+            print_prompt2();
         break;
 /* Non bash-like behaviour. In bash substitution
  * makes in $'string' costruction. */
     case 'a':
-        add_to_buffer(buf, '\a');
+        INPUT_WORD_PUT(&linfo->input, '\a');
         break;
     case 'b':
-        add_to_buffer(buf, '\b');
+        INPUT_WORD_PUT(&linfo->input, '\b');
         break;
     case 'f':
-        add_to_buffer(buf, '\f');
+        INPUT_WORD_PUT(&linfo->input, '\f');
         break;
     case 'n':
-        add_to_buffer(buf, '\n');
+        INPUT_WORD_PUT(&linfo->input, '\n');
         break;
     case 'r':
-        add_to_buffer(buf, '\r');
+        INPUT_WORD_PUT(&linfo->input, '\r');
         break;
     case 't':
-        add_to_buffer(buf, '\t');
+        INPUT_WORD_PUT(&linfo->input, '\t');
         break;
     case 'v':
-        add_to_buffer(buf, '\v');
+        INPUT_WORD_PUT(&linfo->input, '\v');
         break;
     default:
-        add_to_buffer(buf, linfo->c);
+        INPUT_WORD_PUT(&linfo->input, linfo->c);
         break;
     }
 
@@ -289,14 +335,15 @@ lexeme *st_backslash_in_quotes(lexer_info *linfo, buffer *buf)
         linfo->state = ST_ERROR;
         break;
     case '\"':
-        add_to_buffer(buf, linfo->c);
+        INPUT_WORD_PUT(&linfo->input, linfo->c);
         break;
     case '\n':
-        print_prompt2();
+        if (linfo->show_prompts)
+            print_prompt2();
         /* fallthrough */
     default:
-        add_to_buffer(buf, '\\');
-        add_to_buffer(buf, linfo->c);
+        INPUT_WORD_PUT(&linfo->input, '\\');
+        INPUT_WORD_PUT(&linfo->input, linfo->c);
         break;
     }
     deferred_get_char(linfo);
@@ -324,10 +371,11 @@ lexeme *st_in_quotes(lexer_info *linfo, buffer *buf)
         linfo->state = ST_WORD;
         break;
     case '\n':
-        print_prompt2();
+        if (linfo->show_prompts)
+            print_prompt2();
         /* fallthrough */
     default:
-        add_to_buffer(buf, linfo->c);
+        INPUT_WORD_PUT(&linfo->input, linfo->c);
         deferred_get_char(linfo);
         break;
     }
@@ -357,8 +405,8 @@ lexeme *st_word(lexer_info *linfo, buffer *buf)
     case '&':
     case '`':
         linfo->state = ST_START;
-        lex = make_lex(LEX_WORD);
-        lex->str = convert_to_string(buf, 1);
+        lex = make_lex(linfo, LEX_WORD);
+        lex->str = input_word_end(&linfo->input);
         return lex;
     case '\\':
         deferred_get_char(linfo);
@@ -369,7 +417,9 @@ lexeme *st_word(lexer_info *linfo, buffer *buf)
         linfo->state = ST_IN_QUOTES;
         break;
     default:
-        add_to_buffer(buf, linfo->c);
+        INPUT_WORD_PUT(&linfo->input, linfo->c);
+        /* Take rest of plain symbols at once */
+        input_word_run(&linfo->input);
         deferred_get_char(linfo);
     }
 
@@ -380,9 +430,10 @@ lexeme *st_error(lexer_info *linfo, buffer *buf)
 {
     lexeme *lex = NULL;
 
-    lex = make_lex(LEX_ERROR);
+    lex = make_lex(linfo, LEX_ERROR);
     print_state("ST_ERROR", linfo->c);
     clear_buffer(buf);
+    input_word_cancel(&linfo->input);
     linfo->get_next_char = 0;
     linfo->state = ST_START;
     /* TODO: read to '\n' or EOF (flush read buffer) */
@@ -400,10 +451,10 @@ lexeme *st_eoln_eof(lexer_info *linfo, buffer *buf)
 
     switch (linfo->c) {
     case '\n':
-        lex = make_lex(LEX_EOLINE);
+        lex = make_lex(linfo, LEX_EOLINE);
         break;
     case EOF:
-        lex = make_lex(LEX_EOFILE);
+        lex = make_lex(linfo, LEX_EOFILE);
         break;
     default:
         fprintf(stderr, "Lexer: error in ST_EOLN_EOF;");
@@ -417,11 +468,13 @@ lexeme *st_eoln_eof(lexer_info *linfo, buffer *buf)
     return lex;
 }
 
-lexeme *get_lex(lexer_info *linfo)
+lexeme *get_lex(lexer_info *linfo, lexeme *record)
 {
     lexeme *lex = NULL;
     buffer buf;
 
+    linfo->lex = record;
+
     new_buffer(&buf);
 
     do {
@@ -466,30 +519,356 @@ lexeme *get_lex(lexer_info *linfo)
         case ST_EOLN_EOF:
             lex = st_eoln_eof(linfo, &buf);
             break;
+
+        default:
+            /* States of table-driven lexer */
+            lex = st_error(linfo, &buf);
+            break;
         } /* switch */
     } while (lex == NULL);
 
     return lex;
 }
 
+#else /* LEXER_STATE_FUNCTIONS */
+
+/* Table-driven lexer. Each symbol belongs to
+ * class, pair (state, class) gives next state
+ * and action. All tables built at compile time. */
+
+typedef enum symbol_class {
+    C_OTHER,
+    C_EOF,
+    C_NEWLINE,
+    C_BLANK,   /* ' ', '\t' */
+    C_BSLASH,  /* '\\' */
+    C_QUOTE,   /* '\"' */
+    C_LESS,    /* '<'  */
+    C_SEMI,    /* ';'  */
+    C_OPEN,    /* '('  */
+    C_CLOSE,   /* ')'  */
+    C_BQUOTE,  /* '`'  */
+    C_GREATER, /* '>'  */
+    C_PIPE,    /* '|'  */
+    C_AMP,     /* '&'  */
+    COUNT_CLASSES
+} symbol_class;
+
+typedef enum lexer_action {
+    A_SKIP,        /* just take next symbol */
+    A_BEGIN,       /* begin word with '\\' or '\"' */
+    A_BEGIN_PUT,   /* begin word with this symbol */
+    A_PUT,         /* add symbol to word */
+    A_PUT_RUN,     /* add symbol and plain symbols after it */
+    A_PUT_NEWLINE, /* newline in quotes */
+    A_ESCAPE,      /* '\\a', '\\n' and so on */
+    A_CONTINUE,    /* '\\' and newline */
+    A_PUT_BSLASH,  /* '\\' in quotes not before '\"' */
+    A_PUT_BSLASH_NEWLINE,
+    A_WORD,        /* word ended before this symbol */
+    A_ONE,         /* one symbol lexeme */
+    A_TWO,         /* may be first of two symbol lexeme */
+    A_DOUBLE,      /* second symbol of two symbol lexeme */
+    A_SINGLE,      /* there is not second symbol */
+    A_EOLINE,
+    A_EOFILE,
+    A_ERROR
+} lexer_action;
+
+typedef struct transition {
+    unsigned char next;
+    unsigned char action;
+} transition;
+
+#define O  C_OTHER
+#define N  C_NEWLINE
+#define B  C_BLANK
+#define BS C_BSLASH
+#define Q  C_QUOTE
+#define LT C_LESS
+#define SC C_SEMI
+#define OP C_OPEN
+#define CL C_CLOSE
+#define BQ C_BQUOTE
+#define GT C_GREATER
+#define PI C_PIPE
+#define AM C_AMP
+
+/* Indexed by symbol + 1, so EOF is 0 */
+static const unsigned char symbol_classes[257] = {
+    C_EOF, /* EOF */
+    O, O, O, O, O, O, O, O, O, B, N, O, O, O, O, O, /* 0x00 */
+    O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, /* 0x10 */
+    B, O, Q, O, O, O, AM, O, OP, CL, O, O, O, O, O, O, /* 0x20 */
+    O, O, O, O, O, O, O, O, O, O, O, SC, LT, O, GT, O, /* 0x30 */
+    O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, /* 0x40 */
+    O, O, O, O, O, O, O, O, O, O, O, O, BS, O, O, O, /* 0x50 */
+    BQ, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, /* 0x60 */
+    O, O, O, O, O, O, O, O, O, O, O, O, PI, O, O, O, /* 0x70 */
+    O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, /* 0x80 */
+    O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, /* 0x90 */
+    O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, /* 0xa0 */
+    O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, /* 0xb0 */
+    O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, /* 0xc0 */
+    O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, /* 0xd0 */
+    O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, /* 0xe0 */
+    O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O  /* 0xf0 */
+};
+
+#undef O
+#undef N
+#undef B
+#undef BS
+#undef Q
+#undef LT
+#undef SC
+#undef OP
+#undef CL
+#undef BQ
+#undef GT
+#undef PI
+#undef AM
+
+#define T(state, action) { ST_##state, A_##action }
+
+/* Columns in order of symbol_class:
+ * other, EOF, '\n', blank, '\\', '\"',
+ * '<', ';', '(', ')', '`', '>', '|', '&' */
+static const transition transitions[COUNT_DFA_STATES][COUNT_CLASSES] = {
+    { /* ST_START */
+        T(WORD, BEGIN_PUT), T(START, EOFILE), T(START, EOLINE),
+        T(START, SKIP), T(BACKSLASH, BEGIN), T(IN_QUOTES, BEGIN),
+        T(START, ONE), T(START, ONE), T(START, ONE), T(START, ONE),
+        T(START, ONE), T(GREATER, TWO), T(PIPE, TWO),
+        T(AMPERSAND, TWO)
+    },
+    { /* ST_WORD */
+        T(WORD, PUT_RUN), T(START, WORD), T(START, WORD),
+        T(START, WORD), T(BACKSLASH, SKIP), T(IN_QUOTES, SKIP),
+        T(START, WORD), T(START, WORD), T(START, WORD), T(START, WORD),
+        T(START, WORD), T(START, WORD), T(START, WORD),
+        T(START, WORD)
+    },
+    { /* ST_IN_QUOTES */
+        T(IN_QUOTES, PUT), T(START, ERROR), T(IN_QUOTES, PUT_NEWLINE),
+        T(IN_QUOTES, PUT), T(BACKSLASH_IN_QUOTES, SKIP), T(WORD, SKIP),
+        T(IN_QUOTES, PUT), T(IN_QUOTES, PUT), T(IN_QUOTES, PUT),
+        T(IN_QUOTES, PUT), T(IN_QUOTES, PUT), T(IN_QUOTES, PUT),
+        T(IN_QUOTES, PUT), T(IN_QUOTES, PUT)
+    },
+    { /* ST_BACKSLASH */
+        T(WORD, ESCAPE), T(START, ERROR), T(WORD, CONTINUE),
+        T(WORD, PUT), T(WORD, PUT), T(WORD, PUT),
+        T(WORD, PUT), T(WORD, PUT), T(WORD, PUT), T(WORD, PUT),
+        T(WORD, PUT), T(WORD, PUT), T(WORD, PUT),
+        T(WORD, PUT)
+    },
+    { /* ST_BACKSLASH_IN_QUOTES */
+        T(IN_QUOTES, PUT_BSLASH), T(START, ERROR),
+        T(IN_QUOTES, PUT_BSLASH_NEWLINE),
+        T(IN_QUOTES, PUT_BSLASH), T(IN_QUOTES, PUT_BSLASH),
+        T(IN_QUOTES, PUT),
+        T(IN_QUOTES, PUT_BSLASH), T(IN_QUOTES, PUT_BSLASH),
+        T(IN_QUOTES, PUT_BSLASH), T(IN_QUOTES, PUT_BSLASH),
+        T(IN_QUOTES, PUT_BSLASH), T(IN_QUOTES, PUT_BSLASH),
+        T(IN_QUOTES, PUT_BSLASH), T(IN_QUOTES, PUT_BSLASH)
+    },
+    { /* ST_GREATER */
+        T(START, SINGLE), T(START, SINGLE), T(START, SINGLE),
+        T(START, SINGLE), T(START, SINGLE), T(START, SINGLE),
+        T(START, SINGLE), T(START, SINGLE), T(START, SINGLE),
+        T(START, SINGLE), T(START, SINGLE), T(START, DOUBLE),
+        T(START, SINGLE), T(START, SINGLE)
+    },
+    { /* ST_PIPE */
+        T(START, SINGLE), T(START, SINGLE), T(START, SINGLE),
+        T(START, SINGLE), T(START, SINGLE), T(START, SINGLE),
+        T(START, SINGLE), T(START, SINGLE), T(START, SINGLE),
+        T(START, SINGLE), T(START, SINGLE), T(START, SINGLE),
+        T(START, DOUBLE), T(START, SINGLE)
+    },
+    { /* ST_AMPERSAND */
+        T(START, SINGLE), T(START, SINGLE), T(START, SINGLE),
+        T(START, SINGLE), T(START, SINGLE), T(START, SINGLE),
+        T(START, SINGLE), T(START, SINGLE), T(START, SINGLE),
+        T(START, SINGLE), T(START, SINGLE), T(START, SINGLE),
+        T(START, SINGLE), T(START, DOUBLE)
+    }
+};
+
+#undef T
+
+/* Lexeme of A_ONE by class */
+static const unsigned char one_sym_lex[COUNT_CLASSES] = {
+    LEX_ERROR, LEX_ERROR, LEX_ERROR, LEX_ERROR, LEX_ERROR, LEX_ERROR,
+    LEX_INPUT, LEX_SEMICOLON, LEX_BRACKET_OPEN, LEX_BRACKET_CLOSE,
+    LEX_REVERSE, LEX_ERROR, LEX_ERROR, LEX_ERROR
+};
+
+/* Lexemes of A_SINGLE and A_DOUBLE by state */
+static const unsigned char single_sym_lex[COUNT_DFA_STATES] = {
+    LEX_ERROR, LEX_ERROR, LEX_ERROR, LEX_ERROR, LEX_ERROR,
+    LEX_OUTPUT, LEX_PIPE, LEX_BACKGROUND
+};
+
+static const unsigned char double_sym_lex[COUNT_DFA_STATES] = {
+    LEX_ERROR, LEX_ERROR, LEX_ERROR, LEX_ERROR, LEX_ERROR,
+    LEX_APPEND, LEX_OR, LEX_AND
+};
+
+#ifdef LEXER_DEBUG
+static const char *state_names[COUNT_DFA_STATES] = {
+    "ST_START", "ST_WORD", "ST_IN_QUOTES", "ST_BACKSLASH",
+    "ST_BACKSLASH_IN_QUOTES", "ST_GREATER", "ST_PIPE", "ST_AMPERSAND"
+};
+#endif
+
+/* Non bash-like behaviour. In bash substitution
+ * makes in $'string' costruction. */
+int escape_symbol(int c)
+{
+    switch (c) {
+    case 'a':
+        return '\a';
+    case 'b':
+        return '\b';
+    case 'f':
+        return '\f';
+    case 'n':
+        return '\n';
+    case 'r':
+        return '\r';
+    case 't':
+        return '\t';
+    case 'v':
+        return '\v';
+    default:
+        return c;
+    }
+}
+
+lexeme *get_lex(lexer_info *linfo, lexeme *record)
+{
+    input_source *src = &linfo->input;
+    const transition *tr;
+    lexeme *lex = NULL;
+    int state;
+
+    linfo->lex = record;
+
+    do {
+        if (linfo->get_next_char) {
+            linfo->get_next_char = 0;
+            linfo->c = INPUT_GETC(src);
+        }
+
+        state = linfo->state;
+        tr = &transitions[state][symbol_classes[linfo->c + 1]];
+        linfo->state = tr->next;
+
+#ifdef LEXER_DEBUG
+        print_state(state_names[state], linfo->c);
+#endif
+
+        switch (tr->action) {
+        case A_SKIP:
+            /* Only blank skipped in ST_START */
+            if (state == ST_START)
+                linfo->blank = 1;
+            break;
+        case A_BEGIN:
+            input_word_begin(src);
+            break;
+        case A_BEGIN_PUT:
+            input_word_begin(src);
+            /* fallthrough */
+        case A_PUT_RUN:
+            INPUT_WORD_PUT(src, linfo->c);
+            input_word_run(src);
+            break;
+        case A_PUT_NEWLINE:
+            if (linfo->show_prompts)
+                print_prompt2();
+            /* fallthrough */
+        case A_PUT:
+            INPUT_WORD_PUT(src, linfo->c);
+            break;
+        case A_ESCAPE:
+            INPUT_WORD_PUT(src, escape_symbol(linfo->c));
+            break;
+        case A_CONTINUE:
+            /* Ignore newline symbol */
+            if (linfo->show_prompts)
+                print_prompt2();
+            break;
+        case A_PUT_BSLASH_NEWLINE:
+            if (linfo->show_prompts)
+                print_prompt2();
+            /* fallthrough */
+        case A_PUT_BSLASH:
+            INPUT_WORD_PUT(src, '\\');
+            INPUT_WORD_PUT(src, linfo->c);
+            break;
+        case A_WORD:
+            lex = make_lex(linfo, LEX_WORD);
+            lex->str = input_word_end(src);
+            /* Symbol not used */
+            continue;
+        case A_ONE:
+            lex = make_lex(linfo,
+                one_sym_lex[symbol_classes[linfo->c + 1]]);
+            break;
+        case A_TWO:
+            break;
+        case A_DOUBLE:
+            lex = make_lex(linfo, double_sym_lex[state]);
+            break;
+        case A_SINGLE:
+            lex = make_lex(linfo, single_sym_lex[state]);
+            continue;
+        case A_EOLINE:
+            lex = make_lex(linfo, LEX_EOLINE);
+            break;
+        case A_EOFILE:
+            lex = make_lex(linfo, LEX_EOFILE);
+            break;
+        case A_ERROR:
+            print_state("ST_ERROR", linfo->c);
+            input_word_cancel(src);
+            lex = make_lex(linfo, LEX_ERROR);
+            /* TODO: read to '\n' or EOF (flush read buffer) */
+            continue;
+        }
+
+        linfo->get_next_char = 1;
+    } while (lex == NULL);
+
+    return lex;
+}
+
+#endif /* LEXER_STATE_FUNCTIONS */
+
 /*
 gcc -g -Wall -ansi -pedantic -c buffer.c -o buffer.o &&
+gcc -g -Wall -ansi -pedantic -c input.c -o input.o &&
+gcc -g -Wall -ansi -pedantic -c scan.c -o scan.o &&
+gcc -g -Wall -ansi -pedantic -c arena.c -o arena.o &&
 gcc -g -Wall -ansi -pedantic -c utils.c -o utils.o &&
-gcc -g -Wall -ansi -pedantic lexer.c buffer.o utils.o -o lexer
+gcc -g -Wall -ansi -pedantic lexer.c buffer.o input.o scan.o arena.o utils.o -o lexer
 */
 
 #if 0
 int main()
 {
     lexer_info linfo;
-    init_lexer(&linfo);
+    lexeme lex;
+    init_lexer(&linfo, STDIN_FILENO);
 
     do {
-        lexeme *lex = get_lex(&linfo);
-        print_lex(stdout, lex);
-        if (lex->type == LEX_EOFILE)
+        get_lex(&linfo, &lex);
+        print_lex(stdout, &lex);
+        if (lex.type == LEX_EOFILE)
             return 0;
-        destroy_lex(lex);
 
         if (linfo.state == ST_ERROR) {
             fprintf(stderr, "(>_<)\n");
@@ -6,9 +6,14 @@
 #define LEXER_DEBUG
 #endif
 
+/* LEXER_STATE_FUNCTIONS: build lexer with
+ * state functions instead of tables (see
+ * bench_lexer_sf in Makefile) */
+
 #define ES_LEXER_INCURABLE_ERROR 1
 
 #include <stdio.h>
+#include "input.h"
 
 typedef enum type_of_lex {
     LEX_INPUT,         /* '<'  */
@@ -32,31 +37,51 @@ typedef struct lexeme {
 /*    struct lexeme *next; */
     type_of_lex type;
     char *str;
+    /* No blanks between previous lexeme
+     * and this one: word`cmd`word */
+    unsigned int joined:1;
 } lexeme;
 
+/* First COUNT_DFA_STATES states used by
+ * table-driven lexer, others only by state
+ * functions. */
 typedef enum lexer_state {
     ST_START,
+    ST_WORD,
+    ST_IN_QUOTES,
+    ST_BACKSLASH,
+    ST_BACKSLASH_IN_QUOTES,
+    ST_GREATER,   /* '>' or '>>' */
+    ST_PIPE,      /* '|' or '||' */
+    ST_AMPERSAND, /* '&' or '&&' */
     ST_ONE_SYM_LEX,
     /* '<', ';', '(', ')' */
     ST_ONE_TWO_SYM_LEX,
     /* '>', '>>', '|', '||', '&', '&&' */
-    ST_BACKSLASH,
-    ST_BACKSLASH_IN_QUOTES,
-    ST_IN_QUOTES,
     ST_ERROR,
-    ST_WORD,
     ST_EOLN_EOF
 } lexer_state;
 
+#define COUNT_DFA_STATES (ST_AMPERSAND + 1)
+
 typedef struct lexer_info {
     lexer_state state;
     int c; /* current symbol */
     unsigned int get_next_char:1;
+    unsigned int show_prompts:1;
+    /* Blanks skipped after last lexeme */
+    unsigned int blank:1;
+    input_source input;
+    /* Record given to get_lex() */
+    lexeme *lex;
 } lexer_info;
 
-void init_lexer(lexer_info *info);
-lexeme *get_lex(lexer_info *info);
-void destroy_lex(lexeme *lex);
+void init_lexer(lexer_info *info, int fd);
+void init_lexer_str(lexer_info *info, const char *str);
+void destroy_lexer(lexer_info *info);
+int lexer_at_line_start(lexer_info *info);
+void lexer_skip(lexer_info *info, unsigned int len);
+lexeme *get_lex(lexer_info *info, lexeme *record);
 
 void print_lex(FILE *stream, lexeme *lex);
 
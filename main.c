@@ -9,8 +9,11 @@
  * put shell group to foreground */
 
 /* Note: this is not check for
- * interactively/background runned shell. */
-void init_shell(shell_info *sinfo, char **envp)
+ * interactively/background runned shell.
+ * Shell reading script (fd is not stdin)
+ * is not interactive: no job control and
+ * signals of terminal not ignored. */
+void init_shell(shell_info *sinfo, char **envp, int fd)
 {
     char *cur_dir = getcwd(NULL, 0);
     if (cur_dir != NULL) {
@@ -23,59 +26,155 @@ void init_shell(shell_info *sinfo, char **envp)
     new_shell_info(sinfo);
     sinfo->envp = envp;
     sinfo->shell_pgid = getpid();
-    sinfo->shell_interactive = isatty(sinfo->orig_stdin);
+    sinfo->shell_interactive =
+        (fd == STDIN_FILENO && isatty(STDIN_FILENO));
+    init_sigchld();
 
     if (sinfo->shell_interactive) {
         set_sig_ign();
         if (TCSETPGRP_ERROR (
-                tcsetpgrp(sinfo->orig_stdin, sinfo->shell_pgid)))
+                tcsetpgrp(STDIN_FILENO, sinfo->shell_pgid)))
         {
             exit(ES_SYSCALL_FAILED);
         }
     }
 }
 
-int main(int argc, char **argv, char **envp)
+/* SIGCHLD at prompt: report changed jobs
+ * at once and show prompt again */
+void notify_jobs(void *data)
 {
-    shell_info sinfo;
-    cmd_list *list;
-    parser_info pinfo;
+    notify_info *ninfo = (notify_info *) data;
 
-    init_shell(&sinfo, envp);
-    init_parser(&pinfo);
+    drain_sigchld();
+    reap_children(ninfo->sinfo);
+    if (!has_jobs_to_report(ninfo->sinfo))
+        return;
 
-    do {
-        update_jobs_status(&sinfo);
+    dprintf(STDOUT_FILENO, "\n");
+    report_jobs(ninfo->sinfo);
+    if (lexer_at_line_start(ninfo->linfo))
         print_prompt1();
-        list = parse_cmd_list(&pinfo);
+    else
+        print_prompt2();
+}
+
+/* Open script given as first argument.
+ * Commands must not inherit its descriptor
+ * (if it not mapped and closed by lexer). */
+int open_script(const char *path)
+{
+    int fd = open(path, O_RDONLY);
+
+    if (fd == -1) {
+        perror(path);
+        exit(ES_EXEC_ERROR);
+    }
+
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+    return fd;
+}
+
+/* Read, parse and run command lines until end
+ * of input. If exec_last, last external command
+ * of last line replaces shell.
+ * Returns exit status of last line. */
+int run_input(shell_info *sinfo, parser_info *pinfo, int exec_last)
+{
+    cmd_tree *tree;
+    int status = 0;
+
+    do {
+        update_jobs_status(sinfo);
+        if (pinfo->linfo->show_prompts)
+            print_prompt1();
+        /* All of command line allocated here,
+         * background jobs keep it */
+        pinfo->arena = make_arena();
+        tree = parse_cmd_list(pinfo);
 
-        switch (pinfo.error) {
+        switch (pinfo->error) {
         case 0:
 #if 1
-            run_cmd_list(&sinfo, list);
+            status = run_cmd_tree(sinfo, tree,
+                exec_last && pinfo->cur_lex->type == LEX_EOFILE);
 #else
-            print_cmd_list(stdout, list, 1);
-            destroy_cmd_list(list);
+            print_cmd_tree(stdout, tree, 1);
 #endif
-            list = NULL;
+            tree = NULL;
             break;
         case 16:
 #ifdef PARSER_DEBUG
             fprintf(stderr, "Parser: empty command;\n");
 #endif
             /* Empty command is not error */
-            pinfo.error = 0;
+            pinfo->error = 0;
             break;
         default:
-            /* TODO: flush read buffer,
-             * possibly via buffer function. */
+            /* Rest of line already skipped */
             fprintf(stderr, "Parser: bad command;\n");
+            status = pinfo->error;
             break;
         }
 
-        if (pinfo.cur_lex->type == LEX_EOFILE)
-            exit(pinfo.error);
+        if (pinfo->cur_lex->type == LEX_EOFILE)
+            return status;
+
+        release_arena(pinfo->arena);
+        pinfo->arena = NULL;
     } while (1);
+}
+
+/* Usage:
+ * shell [script]
+ * shell -c command_string
+ * With -c no initialization of interactive
+ * shell and no prompts, last command runned
+ * without fork. */
+int main(int argc, char **argv, char **envp)
+{
+    shell_info sinfo;
+    parser_info pinfo;
+    plan_cache plans;
+    path_cache paths;
+    notify_info ninfo;
+    int fd = STDIN_FILENO;
+
+    if (argc > 1 && STR_EQUAL(argv[1], "-c")) {
+        if (argc < 3) {
+            fprintf(stderr, "%s: -c: option requires an argument\n",
+                argv[0]);
+            return ES_BUILTIN_CMD_UNCORRECT_ARGS;
+        }
+
+        new_shell_info(&sinfo);
+        sinfo.envp = envp;
+        sinfo.shell_pgid = getpid();
+        init_sigchld();
+        new_path_cache(&paths);
+        sinfo.paths = &paths;
+        init_parser_str(&pinfo, argv[2]);
+        return run_input(&sinfo, &pinfo, 1);
+    }
+
+    if (argc > 1)
+        fd = open_script(argv[1]);
+
+    init_shell(&sinfo, envp, fd);
+    init_parser(&pinfo, fd);
+    new_plan_cache(&plans);
+    pinfo.cache = sinfo.plans = &plans;
+    new_path_cache(&paths);
+    sinfo.paths = &paths;
+
+    /* Only interactive shell waits at prompt */
+    if (sinfo.shell_interactive) {
+        ninfo.sinfo = &sinfo;
+        ninfo.linfo = pinfo.linfo;
+        pinfo.linfo->input.event_fd = sigchld_pipe[0];
+        pinfo.linfo->input.on_event = notify_jobs;
+        pinfo.linfo->input.event_data = &ninfo;
+    }
 
-    return 0;
+    return run_input(&sinfo, &pinfo, 0);
 }
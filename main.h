@@ -5,4 +5,10 @@
 #include "utils.h"
 #include "parser.h"
 
+/* Data of notify_jobs() */
+typedef struct notify_info {
+    shell_info *sinfo;
+    lexer_info *linfo;
+} notify_info;
+
 #endif
@@ -1,8 +1,11 @@
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <unistd.h>
 
 #include "parser.h"
 #include "word_buffer.h"
+#include "utils.h"
 
 #ifdef PARSER_DEBUG
 void parser_print_action(parser_info *pinfo, const char *where, int leaving)
@@ -31,28 +34,83 @@ void parser_print_error(parser_info *pinfo, const char *where)
 
 void parser_get_lex(parser_info *pinfo);
 
-void init_parser(parser_info *pinfo)
+void init_parser_fields(parser_info *pinfo)
+{
+    pinfo->tokens = NULL;
+    pinfo->count_tokens = 0;
+    pinfo->size_tokens = 0;
+    pinfo->cur_token = 0;
+    pinfo->cur_lex = NULL;
+    pinfo->nodes = NULL;
+    pinfo->count_nodes = 0;
+    pinfo->size_nodes = 0;
+    pinfo->stack = NULL;
+    pinfo->count_stack = 0;
+    pinfo->size_stack = 0;
+    pinfo->in_subst = 0;
+    pinfo->arena = NULL;
+    pinfo->plan = NULL;
+    pinfo->cache = NULL;
+}
+
+void init_parser(parser_info *pinfo, int fd)
 {
 /*  parser_info *pinfo =
         (parser_info *) malloc(sizeof(parser_info)); */
 
     pinfo->linfo = (lexer_info *) malloc(sizeof(lexer_info));
-    init_lexer(pinfo->linfo);
-    pinfo->cur_lex = NULL;
-    pinfo->save_str = 0;
+    init_lexer(pinfo->linfo, fd);
+    init_parser_fields(pinfo);
 }
 
-void parser_get_lex(parser_info *pinfo)
+void init_parser_str(parser_info *pinfo, const char *str)
 {
-    if (pinfo->cur_lex != NULL) {
-        if (pinfo->save_str)
-            free(pinfo->cur_lex);
-        else
-            destroy_lex(pinfo->cur_lex);
-    }
+    pinfo->linfo = (lexer_info *) malloc(sizeof(lexer_info));
+    init_lexer_str(pinfo->linfo, str);
+    init_parser_fields(pinfo);
+}
+
+void destroy_parser(parser_info *pinfo)
+{
+    destroy_lexer(pinfo->linfo);
+    free(pinfo->linfo);
+    free(pinfo->tokens);
+    free(pinfo->nodes);
+    free(pinfo->stack);
+    init_parser_fields(pinfo);
+    pinfo->linfo = NULL;
+}
+
+/* Lex whole command line to pinfo->tokens.
+ * Vector reused for next lines, so operators
+ * and words need no allocation. */
+void parser_read_line(parser_info *pinfo)
+{
+    lexeme *lex;
 
-    pinfo->save_str = 0;
-    pinfo->cur_lex = get_lex(pinfo->linfo);
+    pinfo->count_tokens = 0;
+    pinfo->cur_token = 0;
+
+    do {
+        if (pinfo->count_tokens == pinfo->size_tokens) {
+            pinfo->size_tokens = (pinfo->size_tokens == 0) ?
+                PARSER_TOKENS_SIZE : pinfo->size_tokens * 2;
+            pinfo->tokens = (lexeme *) realloc(pinfo->tokens,
+                sizeof(lexeme) * pinfo->size_tokens);
+        }
+
+        lex = get_lex(pinfo->linfo,
+            pinfo->tokens + (pinfo->count_tokens)++);
+    } while (lex->type != LEX_EOLINE && lex->type != LEX_EOFILE);
+}
+
+/* Take next token of line. Last token
+ * (end of line or file) never passed. */
+void parser_get_lex(parser_info *pinfo)
+{
+    pinfo->cur_lex = pinfo->tokens + pinfo->cur_token;
+    if (pinfo->cur_token + 1 < pinfo->count_tokens)
+        ++(pinfo->cur_token);
 
 #ifdef PARSER_DEBUG
     fprintf(stderr, "Get lex: ");
@@ -65,72 +123,102 @@ void parser_get_lex(parser_info *pinfo)
         pinfo->error = 0; /* Error 0: all right */
 }
 
-cmd_pipeline_item *make_cmd_pipeline_item()
+/* Returns index of new node on stack */
+unsigned int push_node(parser_info *pinfo, type_of_node type)
 {
-    cmd_pipeline_item *simple_cmd =
-        (cmd_pipeline_item *) malloc(sizeof(cmd_pipeline_item));
-    simple_cmd->argv = NULL;
-    simple_cmd->input = NULL;
-    simple_cmd->output = NULL;
-    simple_cmd->append = 0;
-    simple_cmd->cmd_lst = NULL;
-    simple_cmd->next = NULL;
-    return simple_cmd;
-}
+    cmd_node *node;
 
-cmd_pipeline *make_cmd_pipeline()
-{
-    cmd_pipeline *pipeline =
-        (cmd_pipeline *) malloc(sizeof(cmd_pipeline));
-    pipeline->input = NULL;
-    pipeline->output = NULL;
-    pipeline->append = 0;
-    pipeline->first_item = NULL;
-    return pipeline;
-}
+    if (pinfo->count_stack == pinfo->size_stack) {
+        pinfo->size_stack = (pinfo->size_stack == 0) ?
+            PARSER_NODES_SIZE : pinfo->size_stack * 2;
+        pinfo->stack = (cmd_node *) realloc(pinfo->stack,
+            sizeof(cmd_node) * pinfo->size_stack);
+    }
 
-cmd_list_item *make_cmd_list_item()
-{
-    cmd_list_item *list_item =
-        (cmd_list_item *) malloc(sizeof(cmd_list_item));
-    list_item->pl = NULL;
-    list_item->rel = REL_NONE;
-    list_item->next = NULL;
-    return list_item;
+    node = pinfo->stack + pinfo->count_stack;
+    node->type = type;
+    node->rel = REL_NONE;
+    node->foreground = 1;
+    node->append = 0;
+    node->join_prev = 0;
+    node->join_next = 0;
+    node->first = 0;
+    node->count = 0;
+    node->argv = NULL;
+    node->word = 0;
+    node->input = NULL;
+    node->output = NULL;
+    return (pinfo->count_stack)++;
 }
 
-cmd_list *make_cmd_list()
+/* Move nodes above parent from stack
+ * to pinfo->nodes as its children. */
+void pop_children(parser_info *pinfo, unsigned int parent)
 {
-    cmd_list *list =
-        (cmd_list *) malloc(sizeof(cmd_list));
-    list->foreground = 1;
-    list->first_item = NULL;
-    return list;
+    unsigned int count = pinfo->count_stack - parent - 1;
+
+    while (pinfo->count_nodes + count > pinfo->size_nodes) {
+        pinfo->size_nodes = (pinfo->size_nodes == 0) ?
+            PARSER_NODES_SIZE : pinfo->size_nodes * 2;
+        pinfo->nodes = (cmd_node *) realloc(pinfo->nodes,
+            sizeof(cmd_node) * pinfo->size_nodes);
+    }
+
+    memcpy(pinfo->nodes + pinfo->count_nodes,
+        pinfo->stack + parent + 1, sizeof(cmd_node) * count);
+    pinfo->stack[parent].first = pinfo->count_nodes;
+    pinfo->stack[parent].count = count;
+    pinfo->count_nodes += count;
+    pinfo->count_stack = parent + 1;
 }
 
-void print_cmd_list(FILE *stream, cmd_list *list, int newline);
+void print_cmd_list(FILE *stream, cmd_tree *tree, cmd_node *list,
+        int newline);
 
-void print_cmd_pipeline(FILE *stream, cmd_pipeline *pipeline)
+void print_cmd(FILE *stream, cmd_tree *tree, cmd_node *cmd)
 {
-    cmd_pipeline_item *current;
-
-    if (pipeline == NULL) {
-        fprintf(stream, "NULL_PIPELINE");
-        return;
+    cmd_node *subst = CMD_NODE_CHILD(tree, cmd, 0);
+    int joined = 0;
+    unsigned int i;
+
+    for (i = 0; cmd->argv[i] != NULL; ++i) {
+        if (subst < CMD_NODE_CHILD(tree, cmd, cmd->count)
+            && subst->word == i)
+        {
+            if (i != 0 && !subst->join_prev)
+                fprintf(stream, " ");
+            fprintf(stream, "`");
+            print_cmd_list(stream, tree,
+                CMD_NODE_CHILD(tree, subst, 0), 0);
+            fprintf(stream, "`");
+            joined = subst->join_next;
+            ++subst;
+        } else {
+            if (i != 0 && !joined)
+                fprintf(stream, " ");
+            joined = 0;
+            fprintf(stream, "[%s]", cmd->argv[i]);
+        }
     }
+}
+
+void print_cmd_pipeline(FILE *stream, cmd_tree *tree, cmd_node *pipeline)
+{
+    cmd_node *current;
+    unsigned int i;
 
-    current = pipeline->first_item;
-    while (current != NULL) {
-        if (current->cmd_lst == NULL) {
-            print_argv(stream, current->argv);
+    for (i = 0; i < pipeline->count; ++i) {
+        current = CMD_NODE_CHILD(tree, pipeline, i);
+        if (current->type == NODE_CMD) {
+            print_cmd(stream, tree, current);
         } else {
             fprintf(stream, "(");
-            print_cmd_list(stream, current->cmd_lst, 0);
+            print_cmd_list(stream, tree,
+                CMD_NODE_CHILD(tree, current, 0), 0);
             fprintf(stream, ")");
         }
-        if (current->next != NULL)
+        if (i + 1 < pipeline->count)
             fprintf(stream, " | ");
-        current = current->next;
     }
 
     if (pipeline->input != NULL) {
@@ -161,20 +249,16 @@ void print_relation(FILE *stream, type_of_relation rel) {
     }
 }
 
-void print_cmd_list(FILE *stream, cmd_list *list, int newline)
+void print_cmd_list(FILE *stream, cmd_tree *tree, cmd_node *list,
+        int newline)
 {
-    cmd_list_item *current;
-
-    if (list == NULL) {
-        fprintf(stream, "[NULL_CMD_LIST]\n");
-        return;
-    }
+    cmd_node *current;
+    unsigned int i;
 
-    current = list->first_item;
-    while (current != NULL) {
-        print_cmd_pipeline(stream, current->pl);
+    for (i = 0; i < list->count; ++i) {
+        current = CMD_NODE_CHILD(tree, list, i);
+        print_cmd_pipeline(stream, tree, current);
         print_relation(stream, current->rel);
-        current = current->next;
     }
 
     if (!list->foreground)
@@ -183,56 +267,35 @@ void print_cmd_list(FILE *stream, cmd_list *list, int newline)
         fprintf(stream, "\n");
 }
 
-void destroy_cmd_list(cmd_list *list);
-
-void destroy_cmd_pipeline(cmd_pipeline *pipeline)
+void print_cmd_tree(FILE *stream, cmd_tree *tree, int newline)
 {
-    cmd_pipeline_item *current;
-    cmd_pipeline_item *next;
-
-    if (pipeline == NULL)
+    if (tree == NULL) {
+        fprintf(stream, "[NULL_CMD_LIST]\n");
         return;
-
-    current = pipeline->first_item;
-    while (current != NULL) {
-        next = current->next;
-        destroy_argv(current->argv);
-        destroy_cmd_list(current->cmd_lst);
-        free(current);
-        current = next;
     }
 
-    if (pipeline->input != NULL)
-        free(pipeline->input);
-    if (pipeline->output != NULL)
-        free(pipeline->output);
-    free(pipeline);
+    print_cmd_list(stream, tree, CMD_TREE_ROOT(tree), newline);
 }
 
-void destroy_cmd_list(cmd_list *list)
-{
-    cmd_list_item *current;
-    cmd_list_item *next;
-
-    if (list == NULL)
-        return;
-
-    current = list->first_item;
-    while (current != NULL) {
-        next = current->next;
-        destroy_cmd_pipeline(current->pl);
-        free(current);
-        current = next;
-    }
-
-    free(list);
-}
+unsigned int parse_cmd_list_internal(parser_info *pinfo,
+        type_of_lex terminator);
 
-cmd_pipeline_item *parse_cmd_pipeline_item(parser_info *pinfo)
+/* Returns index of command node on stack,
+ * its substitutions moved to nodes. Only
+ * substitutions pushed after node, stack
+ * could be moved by them. */
+unsigned int parse_cmd_pipeline_item(parser_info *pinfo)
 {
-    cmd_pipeline_item *simple_cmd = make_cmd_pipeline_item();
+    unsigned int cmd = push_node(pinfo, NODE_CMD);
+    cmd_node *simple_cmd = pinfo->stack + cmd;
+    unsigned int subst = 0;
+    /* Last lexeme was word of argv or
+     * end of substitution */
+    int after_word = 0;
+    int after_subst = 0;
+    int join_prev;
     word_buffer wbuf;
-    new_word_buffer(&wbuf);
+    new_word_buffer(&wbuf, pinfo->plan);
 
 #ifdef PARSER_DEBUG
     parser_print_action(pinfo, "parse_cmd_pipeline_item()", 0);
@@ -241,9 +304,12 @@ cmd_pipeline_item *parse_cmd_pipeline_item(parser_info *pinfo)
     do {
         switch (pinfo->cur_lex->type) {
         case LEX_WORD:
+            if (after_subst && pinfo->cur_lex->joined)
+                pinfo->stack[subst].join_next = 1;
             /* Add to word buffer for making argv */
             add_to_word_buffer(&wbuf, pinfo->cur_lex->str);
-            pinfo->save_str = 1;
+            after_word = 1;
+            after_subst = 0;
             parser_get_lex(pinfo);
             break;
         case LEX_INPUT:
@@ -261,7 +327,7 @@ cmd_pipeline_item *parse_cmd_pipeline_item(parser_info *pinfo)
                 goto error;
 
             simple_cmd->input = pinfo->cur_lex->str;
-            pinfo->save_str = 1;
+            after_word = after_subst = 0;
             parser_get_lex(pinfo);
             break;
         case LEX_OUTPUT:
@@ -281,9 +347,37 @@ cmd_pipeline_item *parse_cmd_pipeline_item(parser_info *pinfo)
                 goto error;
 
             simple_cmd->output = pinfo->cur_lex->str;
-            pinfo->save_str = 1;
+            after_word = after_subst = 0;
             parser_get_lex(pinfo);
             break;
+        case LEX_REVERSE:
+            /* Substitutions not nested */
+            if (!pinfo->in_subst) {
+                join_prev = pinfo->cur_lex->joined
+                    && (after_word || after_subst);
+                if (join_prev && after_subst)
+                    pinfo->stack[subst].join_next = 1;
+
+                /* Word filled by runner */
+                subst = push_node(pinfo, NODE_SUBST);
+                pinfo->stack[subst].word = wbuf.count_words;
+                pinfo->stack[subst].join_prev = join_prev;
+                add_to_word_buffer(&wbuf, SUBST_WORD);
+
+                pinfo->in_subst = 1;
+                parse_cmd_list_internal(pinfo, LEX_REVERSE);
+                pinfo->in_subst = 0;
+                if (pinfo->error)
+                    goto error;
+
+                pop_children(pinfo, subst);
+                simple_cmd = pinfo->stack + cmd;
+                after_word = 0;
+                after_subst = 1;
+                parser_get_lex(pinfo);
+                break;
+            }
+            /* Fall through: end of substitution */
         default:
             /* Lexer error possible */
             if (pinfo->error)
@@ -295,10 +389,11 @@ cmd_pipeline_item *parse_cmd_pipeline_item(parser_info *pinfo)
 
             /* make argv from word buffer */
             simple_cmd->argv = convert_to_argv(&wbuf, 1);
+            pop_children(pinfo, cmd);
 #ifdef PARSER_DEBUG
             parser_print_action(pinfo, "parse_cmd_pipeline_item()", 1);
 #endif
-            return simple_cmd;
+            return cmd;
         }
     } while (!pinfo->error);
 
@@ -306,21 +401,17 @@ error:
 #ifdef PARSER_DEBUG
     parser_print_error(pinfo, "parse_cmd_pipeline_item()");
 #endif
-    clear_word_buffer(&wbuf, 1);
-    if (simple_cmd->input != NULL)
-        free(simple_cmd->input);
-    if (simple_cmd->output != NULL)
-        free(simple_cmd->output);
-    free(simple_cmd);
-    return NULL;
+    clear_word_buffer(&wbuf);
+    return cmd;
 }
 
-cmd_list *parse_cmd_list(parser_info *pinfo);
-
-cmd_pipeline *parse_cmd_pipeline(parser_info *pinfo)
+/* Returns index of pipeline node on stack,
+ * its commands and subshells moved to nodes. */
+unsigned int parse_cmd_pipeline(parser_info *pinfo)
 {
-    cmd_pipeline *pipeline = make_cmd_pipeline();
-    cmd_pipeline_item *cur_item = NULL, *tmp_item = NULL;
+    unsigned int pl = push_node(pinfo, NODE_PIPELINE);
+    unsigned int cur = 0;
+    cmd_node *cur_item;
 
 #ifdef PARSER_DEBUG
     parser_print_action(pinfo, "parse_cmd_pipeline()", 0);
@@ -329,16 +420,16 @@ cmd_pipeline *parse_cmd_pipeline(parser_info *pinfo)
     do {
         switch (pinfo->cur_lex->type) {
         case LEX_WORD:
-            tmp_item = parse_cmd_pipeline_item(pinfo);
+        case LEX_REVERSE:
+            cur = parse_cmd_pipeline_item(pinfo);
             break;
         case LEX_BRACKET_OPEN:
-            tmp_item = make_cmd_pipeline_item();
-            tmp_item->cmd_lst = parse_cmd_list(pinfo);
-            if (pinfo->error) {
-                free(tmp_item);
+            cur = push_node(pinfo, NODE_SUBSHELL);
+            parse_cmd_list_internal(pinfo, LEX_BRACKET_CLOSE);
+            if (pinfo->error)
                 goto error;
-            }
 
+            pop_children(pinfo, cur);
             parser_get_lex(pinfo);
             break;
         default:
@@ -349,45 +440,37 @@ cmd_pipeline *parse_cmd_pipeline(parser_info *pinfo)
         if (pinfo->error)
             goto error;
 
-        if (pipeline->first_item == NULL) {
+        cur_item = pinfo->stack + cur;
+        if (cur == pl + 1) {
             /* First simple cmd */
-            pipeline->first_item = cur_item = tmp_item;
-            pipeline->input = cur_item->input;
+            pinfo->stack[pl].input = cur_item->input;
             cur_item->input = NULL;
         } else {
             /* Second and following simple cmd */
-            cur_item = cur_item->next = tmp_item;
             pinfo->error = (cur_item->input == NULL) ? 0 : 8; /* Error 8 */
-            if (pinfo->error) {
-                free(cur_item->input);
-                if (cur_item->output != NULL)
-                    free(cur_item->output);
+            if (pinfo->error)
                 goto error;
-            }
         }
 
         if (pinfo->cur_lex->type == LEX_PIPE) {
             /* Not last simple cmd */
             pinfo->error = (cur_item->output == NULL) ? 0 : 9; /* Error 9 */
-            if (pinfo->error) {
-                free(cur_item->output);
-                if (cur_item->input != NULL)
-                    free(cur_item->input);
+            if (pinfo->error)
                 goto error;
-            }
 
             parser_get_lex(pinfo);
             continue;
         } else {
             /* Last simple cmd in this pipeline */
-            pipeline->output = cur_item->output;
-            pipeline->append = cur_item->append;
+            pinfo->stack[pl].output = cur_item->output;
+            pinfo->stack[pl].append = cur_item->append;
             cur_item->output = NULL;
             cur_item->append = 0;
+            pop_children(pinfo, pl);
 #ifdef PARSER_DEBUG
             parser_print_action(pinfo, "parse_cmd_pipeline()", 1);
 #endif
-            return pipeline;
+            return pl;
         }
     } while (!pinfo->error);
 
@@ -395,38 +478,40 @@ error:
 #ifdef PARSER_DEBUG
     parser_print_error(pinfo, "parse_cmd_pipeline()");
 #endif
-    destroy_cmd_pipeline(pipeline);
-    return NULL;
+    return pl;
 }
 
-cmd_list_item *parse_cmd_list_item(parser_info *pinfo)
+/* Returns index of pipeline node on stack */
+unsigned int parse_cmd_list_item(parser_info *pinfo)
 {
-    cmd_list_item *list_item = make_cmd_list_item();
+    unsigned int pl;
+    type_of_relation rel;
 
 #ifdef PARSER_DEBUG
     parser_print_action(pinfo, "parse_cmd_list_item()", 0);
 #endif
 
-    list_item->pl = parse_cmd_pipeline(pinfo);
+    pl = parse_cmd_pipeline(pinfo);
     if (pinfo->error)
         goto error;
 
     switch (pinfo->cur_lex->type) {
     case LEX_OR:
-        list_item->rel = REL_OR;
+        rel = REL_OR;
         break;
     case LEX_AND:
-        list_item->rel = REL_AND;
+        rel = REL_AND;
         break;
     case LEX_SEMICOLON:
-        list_item->rel = REL_BOTH;
+        rel = REL_BOTH;
         break;
     default:
-        list_item->rel = REL_NONE;
+        rel = REL_NONE;
         break;
     }
 
-    if (list_item->rel != REL_NONE)
+    pinfo->stack[pl].rel = rel;
+    if (rel != REL_NONE)
         parser_get_lex(pinfo);
 
     if (pinfo->error)
@@ -435,30 +520,32 @@ cmd_list_item *parse_cmd_list_item(parser_info *pinfo)
 #ifdef PARSER_DEBUG
     parser_print_action(pinfo, "parse_cmd_list_item()", 1);
 #endif
-    return list_item;
+    return pl;
 
 error:
 #ifdef PARSER_DEBUG
     parser_print_error(pinfo, "parse_cmd_list_item()");
 #endif
-    free(list_item);
-    return NULL;
+    return pl;
 }
 
-cmd_list *parse_cmd_list(parser_info *pinfo)
+/* Returns index of list node on stack,
+ * its pipelines moved to nodes. List of
+ * line terminated by LEX_EOLINE (or by
+ * LEX_EOFILE), list of subshell by
+ * LEX_BRACKET_CLOSE, list of substitution
+ * by LEX_REVERSE. */
+unsigned int parse_cmd_list_internal(parser_info *pinfo,
+        type_of_lex terminator)
 {
-    int bracket_terminated = 0;
     int lex_term = 0;
-    cmd_list *list = make_cmd_list(pinfo);
-    cmd_list_item *cur_item = NULL, *tmp_item = NULL;
+    unsigned int list = push_node(pinfo, NODE_LIST);
+    unsigned int cur = 0;
 
 #ifdef PARSER_DEBUG
     parser_print_action(pinfo, "parse_cmd_list()", 0);
 #endif
 
-    if (pinfo->cur_lex != NULL)
-        bracket_terminated = (pinfo->cur_lex->type == LEX_BRACKET_OPEN);
-
     parser_get_lex(pinfo);
     if (pinfo->error)
         goto error;
@@ -475,24 +562,21 @@ cmd_list *parse_cmd_list(parser_info *pinfo)
     }
 
     do {
-        tmp_item = parse_cmd_list_item(pinfo);
+        cur = parse_cmd_list_item(pinfo);
         if (pinfo->error)
             goto error;
 
-        if (list->first_item == NULL)
-            list->first_item = cur_item = tmp_item;
-        else
-            cur_item = cur_item->next = tmp_item;
-
         switch (pinfo->cur_lex->type) {
         case LEX_BACKGROUND:
         case LEX_BRACKET_CLOSE:
+        case LEX_REVERSE:
         case LEX_EOLINE:
         case LEX_EOFILE:
             lex_term = 1;
             break;
         default:
-            pinfo->error = (cur_item->rel == REL_NONE) ? 15 : 0; /* Error 15 */
+            pinfo->error = (pinfo->stack[cur].rel == REL_NONE) ?
+                15 : 0; /* Error 15 */
             break;
         }
     } while (!lex_term && !pinfo->error);
@@ -501,10 +585,11 @@ cmd_list *parse_cmd_list(parser_info *pinfo)
         goto error;
 
     if (pinfo->cur_lex->type == LEX_BACKGROUND) {
-        pinfo->error = (cur_item->rel == REL_NONE) ? 0 : 13; /* Error 13 */
+        pinfo->error = (pinfo->stack[cur].rel == REL_NONE) ?
+            0 : 13; /* Error 13 */
         if (pinfo->error)
             goto error;
-        list->foreground = 0;
+        pinfo->stack[list].foreground = 0;
         parser_get_lex(pinfo);
     }
 
@@ -513,11 +598,13 @@ cmd_list *parse_cmd_list(parser_info *pinfo)
 
     switch (pinfo->cur_lex->type) {
     case LEX_BRACKET_CLOSE:
-        pinfo->error = (bracket_terminated) ? 0 : 5; /* Error 5 */
+    case LEX_REVERSE:
+        pinfo->error = (pinfo->cur_lex->type == terminator) ?
+            0 : 5; /* Error 5 */
         break;
     case LEX_EOLINE:
     case LEX_EOFILE:
-        pinfo->error = (bracket_terminated) ? 6 : 0; /* Error 6 */
+        pinfo->error = (terminator == LEX_EOLINE) ? 0 : 6; /* Error 6 */
         break;
     default:
         pinfo->error = 14; /* Error 14 */
@@ -527,12 +614,13 @@ cmd_list *parse_cmd_list(parser_info *pinfo)
     if (pinfo->error)
         goto error;
 
-    pinfo->error = ((cur_item->rel == REL_NONE)
-        || (cur_item->rel == REL_BOTH)) ? 0 : 7; /* Error 7 */
+    pinfo->error = ((pinfo->stack[cur].rel == REL_NONE)
+        || (pinfo->stack[cur].rel == REL_BOTH)) ? 0 : 7; /* Error 7 */
     if (pinfo->error)
         goto error;
 
-    cur_item->rel = REL_NONE;
+    pinfo->stack[cur].rel = REL_NONE;
+    pop_children(pinfo, list);
 
 #ifdef PARSER_DEBUG
     parser_print_action(pinfo, "parse_cmd_list()", 1);
@@ -543,15 +631,123 @@ error:
 #ifdef PARSER_DEBUG
     parser_print_error(pinfo, "parse_cmd_list()");
 #endif
-    destroy_cmd_list(list);
-    return NULL;
+    return list;
+}
+
+/* Tokens of line, which plan cached:
+ * only end of line. */
+void parser_cached_line(parser_info *pinfo)
+{
+    if (pinfo->size_tokens == 0) {
+        pinfo->size_tokens = PARSER_TOKENS_SIZE;
+        pinfo->tokens = (lexeme *) malloc(sizeof(lexeme)
+            * pinfo->size_tokens);
+    }
+
+    pinfo->tokens->type = LEX_EOLINE;
+    pinfo->tokens->str = NULL;
+    pinfo->tokens->joined = 0;
+    pinfo->count_tokens = 1;
+    pinfo->cur_token = 0;
+    pinfo->cur_lex = pinfo->tokens;
+    pinfo->error = 0;
+}
+
+/* Tree of plan for caller: header in run
+ * arena (pinfo->arena), which retains plan. */
+cmd_tree *tree_for_run(parser_info *pinfo, cmd_tree *plan_tree)
+{
+    cmd_tree *tree =
+        (cmd_tree *) arena_alloc(pinfo->arena, sizeof(cmd_tree));
+    tree->nodes = plan_tree->nodes;
+    tree->count_nodes = plan_tree->count_nodes;
+    tree->arena = pinfo->arena;
+    return tree;
+}
+
+/* Plan (tree as one node array, words and input
+ * line with them) allocated in own arena, which
+ * retained by pinfo->arena. Line read before
+ * parsing, so on error rest of line skipped.
+ * If cache given, line, which plan cached,
+ * not lexed and parsed again. Only lines without
+ * continuation (line ends with first '\n') are
+ * cached, raw line hashed before lexing changes
+ * it in place. */
+cmd_tree *parse_cmd_list(parser_info *pinfo)
+{
+    input_source *src = &pinfo->linfo->input;
+    const char *raw = NULL;
+    char *raw_copy = NULL;
+    unsigned int len = 0;
+    unsigned int consumed;
+    unsigned long hash = 0;
+    cmd_tree *tree;
+    unsigned int count;
+
+    input_line_begin(src);
+
+    if (pinfo->cache != NULL && lexer_at_line_start(pinfo->linfo))
+        raw = input_peek_line(src, &len);
+
+    if (raw != NULL) {
+        hash = fnv_hash(raw, len);
+        tree = plan_cache_lookup(pinfo->cache, hash, raw, len);
+        if (tree != NULL) {
+            release_input_line(input_line_end(src));
+            lexer_skip(pinfo->linfo, len);
+            parser_cached_line(pinfo);
+            ref_arena(tree->arena);
+            pinfo->arena->base = tree->arena;
+            return tree_for_run(pinfo, tree);
+        }
+    }
+
+    /* Run arena takes reference */
+    pinfo->plan = pinfo->arena->base = make_arena();
+    if (raw != NULL) {
+        raw_copy = (char *) arena_alloc(pinfo->plan, len);
+        memcpy(raw_copy, raw, len);
+    }
+
+    parser_read_line(pinfo);
+    consumed = src->pos - src->line_start;
+    pinfo->plan->line = input_line_end(src);
+
+    pinfo->count_nodes = 0;
+    pinfo->count_stack = 0;
+    pinfo->in_subst = 0;
+    parse_cmd_list_internal(pinfo, LEX_EOLINE);
+    if (pinfo->error) {
+        pinfo->cur_lex = pinfo->tokens + pinfo->count_tokens - 1;
+        return NULL;
+    }
+
+    /* Root list is the only node on stack */
+    count = pinfo->count_nodes;
+    tree = (cmd_tree *) arena_alloc(pinfo->plan, sizeof(cmd_tree));
+    tree->nodes = (cmd_node *) arena_alloc(pinfo->plan,
+        sizeof(cmd_node) * (count + 1));
+    memcpy(tree->nodes, pinfo->nodes, sizeof(cmd_node) * count);
+    tree->nodes[count] = pinfo->stack[0];
+    tree->count_nodes = count + 1;
+    tree->arena = pinfo->plan;
+
+    if (raw_copy != NULL && consumed == len)
+        plan_cache_insert(pinfo->cache, hash, raw_copy, len,
+            tree, pinfo->plan);
+
+    return tree_for_run(pinfo, tree);
 }
 
 /* Compile:
 gcc -g -Wall -ansi -pedantic -c buffer.c -o buffer.o &&
+gcc -g -Wall -ansi -pedantic -c input.c -o input.o &&
+gcc -g -Wall -ansi -pedantic -c scan.c -o scan.o &&
+gcc -g -Wall -ansi -pedantic -c arena.c -o arena.o &&
 gcc -g -Wall -ansi -pedantic -c lexer.c -o lexer.o &&
 gcc -g -Wall -ansi -pedantic -c word_buffer.c -o word_buffer.o &&
-gcc -g -Wall -ansi -pedantic parser.c buffer.o lexer.o word_buffer.o -o parser
+gcc -g -Wall -ansi -pedantic parser.c buffer.o input.o scan.o arena.o lexer.o word_buffer.o -o parser
  * Grep possible parsing errors:
 grep -Pn '\* Error \d+ \*' parser.c
 */
@@ -559,31 +755,31 @@ grep -Pn '\* Error \d+ \*' parser.c
 #if 0
 int main()
 {
-    cmd_list *list;
+    cmd_tree *tree;
     parser_info pinfo;
-    init_parser(&pinfo);
+    init_parser(&pinfo, STDIN_FILENO);
 
     do {
-        list = parse_cmd_list(&pinfo);
+        pinfo.arena = make_arena();
+        tree = parse_cmd_list(&pinfo);
 
         switch (pinfo.error) {
         case 0:
-            print_cmd_list(stdout, list, 1);
-            destroy_cmd_list(list);
-            list = NULL;
+            print_cmd_tree(stdout, tree, 1);
+            tree = NULL;
             break;
         case 16:
             fprintf(stderr, "Parser: empty command;\n");
             break;
         default:
-            /* TODO: flush read buffer,
-             * possibly via buffer function. */
+            /* Rest of line already skipped */
             fprintf(stderr, "Parser: bad command;\n");
             break;
         }
 
         if (pinfo.cur_lex->type == LEX_EOFILE)
             exit(pinfo.error);
+        release_arena(pinfo.arena);
     } while (1);
 
     return 0;
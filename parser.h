@@ -3,30 +3,14 @@
 
 #include <stdio.h>
 #include "lexer.h"
+#include "arena.h"
+#include "plan_cache.h"
 
 /* Not defined by default */
 #if !defined(PARSER_DEBUG) && 0
 #define PARSER_DEBUG
 #endif
 
-typedef struct cmd_pipeline_item {
-    /* Item data: */
-    char **argv;
-    char *input;  /* temporally */
-    char *output; /* temporally */
-    unsigned int append:1; /* temporally */
-    struct cmd_list *cmd_lst;
-    /* End of item data */
-    struct cmd_pipeline_item *next;
-} cmd_pipeline_item;
-
-typedef struct cmd_pipeline {
-    char *input;
-    char *output;
-    unsigned int append:1;
-    struct cmd_pipeline_item *first_item;
-} cmd_pipeline;
-
 typedef enum type_of_relation {
     REL_NONE,  /* no relation */
     REL_OR,    /* '||' */
@@ -34,30 +18,103 @@ typedef enum type_of_relation {
     REL_BOTH   /* ';'  */
 } type_of_relation;
 
-typedef struct cmd_list_item {
-    /* Item data: */
-    struct cmd_pipeline *pl;
-    type_of_relation rel;
-    /* End of item data */
-    struct cmd_list_item *next;
-} cmd_list_item;
+typedef enum type_of_node {
+    NODE_LIST,     /* pipelines with relations */
+    NODE_PIPELINE, /* commands and subshells */
+    NODE_CMD,      /* simple command */
+    NODE_SUBSHELL, /* list in brackets */
+    NODE_SUBST     /* list in backquotes */
+} type_of_node;
 
-typedef struct cmd_list {
+/* Word of argv, which replaced by output
+ * of substitution at run. Output joined
+ * with words next to it without blanks. */
+#define SUBST_WORD "`"
+
+/* Node of command tree. Children of node are
+ * nodes first .. first + count - 1 of the same
+ * array, child of subshell or substitution is
+ * its list, children of command are its
+ * substitutions. */
+typedef struct cmd_node {
+    type_of_node type;
+    /* NODE_PIPELINE: relation with next pipeline */
+    type_of_relation rel;
+    /* NODE_LIST: not terminated by '&' */
     unsigned int foreground:1;
-    struct cmd_list_item *first_item;
-} cmd_list;
+    /* NODE_PIPELINE: output by '>>' */
+    unsigned int append:1;
+    /* NODE_SUBST: no blanks before it,
+     * after it (word`cmd`word) */
+    unsigned int join_prev:1;
+    unsigned int join_next:1;
+    unsigned int first;
+    unsigned int count;
+    char **argv;  /* NODE_CMD */
+    /* NODE_SUBST: index of its word in argv */
+    unsigned int word;
+    char *input;  /* NODE_PIPELINE */
+    char *output; /* NODE_PIPELINE */
+} cmd_node;
+
+/* All nodes of command line in one array,
+ * children before parents, root list last. */
+typedef struct cmd_tree {
+    cmd_node *nodes;
+    unsigned int count_nodes;
+    /* Arena of command line */
+    arena *arena;
+} cmd_tree;
+
+#define CMD_TREE_ROOT(tree) \
+    ((tree)->nodes + (tree)->count_nodes - 1)
+#define CMD_NODE_CHILD(tree, node, i) \
+    ((tree)->nodes + (node)->first + (i))
+
+/* Initial size of token vector */
+#ifndef PARSER_TOKENS_SIZE
+#define PARSER_TOKENS_SIZE 64
+#endif
+
+/* Initial size of node vectors */
+#ifndef PARSER_NODES_SIZE
+#define PARSER_NODES_SIZE 32
+#endif
 
 typedef struct parser_info {
     lexer_info *linfo;
+    /* Tokens of current line */
+    lexeme *tokens;
+    unsigned int count_tokens;
+    unsigned int size_tokens;
+    unsigned int cur_token; /* index of next token */
     lexeme *cur_lex;
+    /* Nodes of current line. Children of
+     * node collected on stack and moved to
+     * nodes, when node parsed. */
+    cmd_node *nodes;
+    unsigned int count_nodes;
+    unsigned int size_nodes;
+    cmd_node *stack;
+    unsigned int count_stack;
+    unsigned int size_stack;
+    /* Parsing list in backquotes */
+    unsigned int in_subst:1;
     int error;
-    unsigned int save_str;
+    /* Set by caller before parse_cmd_list():
+     * arena of run, it retains plan */
+    arena *arena;
+    /* Plan of current line: nodes and words */
+    arena *plan;
+    /* NULL, if plans not cached */
+    plan_cache *cache;
 } parser_info;
 
-void init_parser(parser_info *pinfo);
-cmd_list *parse_cmd_list(parser_info *pinfo);
-void destroy_cmd_list(cmd_list *list);
+void init_parser(parser_info *pinfo, int fd);
+void init_parser_str(parser_info *pinfo, const char *str);
+void destroy_parser(parser_info *pinfo);
+cmd_tree *parse_cmd_list(parser_info *pinfo);
 
-void print_cmd_list(FILE *stream, cmd_list *list, int newline);
+void print_cmd_tree(FILE *stream, cmd_tree *tree, int newline);
 
 #endif
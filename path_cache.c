@@ -0,0 +1,237 @@
+/* For st_mtim */
+#define _DEFAULT_SOURCE
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "path_cache.h"
+#include "utils.h"
+
+void new_path_cache(path_cache *cache)
+{
+/*  path_cache *cache = (path_cache *) malloc(sizeof(path_cache)); */
+    unsigned int i;
+
+    for (i = 0; i < PATH_CACHE_BUCKETS; ++i)
+        cache->buckets[i] = NULL;
+
+    cache->count_entries = 0;
+    cache->path = NULL;
+    cache->dirs = NULL;
+    cache->count_dirs = 0;
+    cache->file = NULL;
+    cache->hits = 0;
+    cache->misses = 0;
+}
+
+/* Forget commands and PATH, counters kept */
+void clear_path_cache(path_cache *cache)
+{
+    unsigned long hits = cache->hits;
+    unsigned long misses = cache->misses;
+    path_entry *e, *next;
+    unsigned int i;
+
+    for (i = 0; i < PATH_CACHE_BUCKETS; ++i) {
+        for (e = cache->buckets[i]; e != NULL; e = next) {
+            next = e->next;
+            free(e->name);
+            free(e->file);
+            free(e);
+        }
+    }
+
+    free(cache->path);
+    free(cache->dirs);
+    free(cache->file);
+
+    new_path_cache(cache);
+    cache->hits = hits;
+    cache->misses = misses;
+}
+
+/* Returns 1, if modification time
+ * differs from saved one */
+int stat_dir(path_dir *dir, int save)
+{
+    struct stat st;
+    time_t sec = 0;
+    long nsec = 0;
+    int changed;
+
+    if (stat(dir->name, &st) == 0) {
+        sec = st.st_mtim.tv_sec;
+        nsec = st.st_mtim.tv_nsec;
+    }
+
+    changed = (sec != dir->mtime_sec || nsec != dir->mtime_nsec);
+    if (save) {
+        dir->mtime_sec = sec;
+        dir->mtime_nsec = nsec;
+    }
+
+    return changed;
+}
+
+/* Returns 1, if one of count first absolute
+ * directories modified */
+int dirs_changed(path_cache *cache, unsigned int count)
+{
+    unsigned int i;
+
+    for (i = 0; i < count; ++i) {
+        if (!cache->dirs[i].relative && stat_dir(cache->dirs + i, 0))
+            return 1;
+    }
+
+    return 0;
+}
+
+/* Keep PATH and its directories with
+ * modification times. Copy of PATH
+ * kept twice: as is, to compare with
+ * environment, and splitted by ':'. */
+void split_path(path_cache *cache, const char *path)
+{
+    unsigned int len = strlen(path);
+    unsigned int i;
+    char *dir;
+
+    cache->path = (char *) malloc(2 * (len + 1));
+    memcpy(cache->path, path, len + 1);
+    dir = memcpy(cache->path + len + 1, path, len + 1);
+
+    cache->count_dirs = 1;
+    for (i = 0; i < len; ++i) {
+        if (path[i] == ':')
+            ++(cache->count_dirs);
+    }
+
+    cache->dirs = (path_dir *) malloc(sizeof(path_dir)
+        * cache->count_dirs);
+
+    for (i = 0; i < cache->count_dirs; ++i) {
+        cache->dirs[i].name = dir;
+        dir += strcspn(dir, ":");
+        *(dir++) = '\0';
+
+        /* Empty means current directory */
+        if (*(cache->dirs[i].name) == '\0')
+            cache->dirs[i].name = ".";
+        cache->dirs[i].relative = (*(cache->dirs[i].name) != '/');
+        stat_dir(cache->dirs + i, 1);
+    }
+}
+
+/* Returns allocated name of executable
+ * regular file or NULL. Sets *denied, if
+ * file exists, but exec would fail with
+ * EACCES (not regular or not executable). */
+char *find_in_dir(path_dir *dir, const char *name, int *denied)
+{
+    unsigned int len = strlen(dir->name);
+    char *file = (char *) malloc(len + strlen(name) + 2);
+    struct stat st;
+
+    memcpy(file, dir->name, len);
+    file[len] = '/';
+    strcpy(file + len + 1, name);
+
+    errno = 0;
+    if (stat(file, &st) == 0 && S_ISREG(st.st_mode)
+        && access(file, X_OK) == 0)
+    {
+        return file;
+    }
+
+    if (errno != ENOENT && errno != ENOTDIR)
+        *denied = 1;
+    free(file);
+    return NULL;
+}
+
+void insert_entry(path_cache *cache, unsigned long hash,
+    const char *name, char *file, unsigned int dir)
+{
+    path_entry *e = (path_entry *) malloc(sizeof(path_entry));
+
+    e->name = (char *) malloc(strlen(name) + 1);
+    strcpy(e->name, name);
+    e->file = file;
+    e->dir = dir;
+    e->hits = 1;
+
+    e->next = cache->buckets[hash % PATH_CACHE_BUCKETS];
+    cache->buckets[hash % PATH_CACHE_BUCKETS] = e;
+    ++(cache->count_entries);
+}
+
+/* Resolve command name as execvp() does.
+ * Returns file to exec or NULL with errno:
+ * EACCES, if only not executable files
+ * found (search goes on after them, as in
+ * execvp()), ENOENT otherwise. Name with '/'
+ * returned as is. File valid until next call. */
+const char *path_cache_lookup(path_cache *cache, const char *name)
+{
+    const char *path = getenv("PATH");
+    unsigned long hash;
+    unsigned int i;
+    path_entry *e;
+    char *file = NULL;
+    int denied = 0;
+
+    if (strchr(name, '/') != NULL)
+        return name;
+
+    if (path == NULL)
+        path = PATH_CACHE_DEFAULT_PATH;
+
+    if (cache->path == NULL || strcmp(cache->path, path) != 0) {
+        clear_path_cache(cache);
+        split_path(cache, path);
+    }
+
+    hash = fnv_hash(name, strlen(name));
+    for (e = cache->buckets[hash % PATH_CACHE_BUCKETS];
+        e != NULL && strcmp(e->name, name) != 0;
+        e = e->next)
+    {
+        /* Empty */
+    }
+
+    /* Directories before file could get
+     * command, its directory could lose it */
+    if (e != NULL && !dirs_changed(cache, e->dir + 1)) {
+        ++(e->hits);
+        ++(cache->hits);
+        return e->file;
+    }
+
+    ++(cache->misses);
+    if (dirs_changed(cache, cache->count_dirs)) {
+        clear_path_cache(cache);
+        split_path(cache, path);
+    }
+
+    for (i = 0; i < cache->count_dirs && file == NULL; ++i)
+        file = find_in_dir(cache->dirs + i, name, &denied);
+
+    if (file == NULL) {
+        errno = denied ? EACCES : ENOENT;
+        return NULL;
+    }
+
+    if (cache->dirs[i - 1].relative) {
+        free(cache->file);
+        cache->file = file;
+    } else {
+        insert_entry(cache, hash, name, file, i - 1);
+    }
+
+    return file;
+}
@@ -0,0 +1,53 @@
+#ifndef PATH_CACHE_H_SENTRY
+#define PATH_CACHE_H_SENTRY
+
+#include <time.h>
+
+#ifndef PATH_CACHE_BUCKETS
+#define PATH_CACHE_BUCKETS 64
+#endif
+
+/* Used, if PATH unset (as execvp() does) */
+#define PATH_CACHE_DEFAULT_PATH "/bin:/usr/bin"
+
+/* Command name resolved to file in PATH */
+typedef struct path_entry {
+    char *name;
+    char *file;
+    /* Index of directory in PATH */
+    unsigned int dir;
+    unsigned long hits;
+    struct path_entry *next;
+} path_entry;
+
+/* Directory of PATH and its modification
+ * time, when cache was filled */
+typedef struct path_dir {
+    char *name;
+    unsigned int relative:1;
+    time_t mtime_sec;
+    long mtime_nsec;
+} path_dir;
+
+/* Hash table of command names. Forgotten if PATH
+ * changed or one of directories before found
+ * file modified. Commands from relative
+ * directories are not cached. */
+typedef struct path_cache {
+    path_entry *buckets[PATH_CACHE_BUCKETS];
+    unsigned int count_entries;
+    /* Copy of PATH, directories point into it */
+    char *path;
+    path_dir *dirs;
+    unsigned int count_dirs;
+    /* Last resolved file, if not cached */
+    char *file;
+    unsigned long hits;
+    unsigned long misses;
+} path_cache;
+
+void new_path_cache(path_cache *cache);
+void clear_path_cache(path_cache *cache);
+const char *path_cache_lookup(path_cache *cache, const char *name);
+
+#endif
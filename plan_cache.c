@@ -0,0 +1,132 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "plan_cache.h"
+
+void new_plan_cache(plan_cache *cache)
+{
+/*  plan_cache *cache = (plan_cache *) malloc(sizeof(plan_cache)); */
+    unsigned int i;
+
+    for (i = 0; i < PLAN_CACHE_BUCKETS; ++i)
+        cache->buckets[i] = -1;
+
+    cache->count_entries = 0;
+    cache->first = -1;
+    cache->last = -1;
+    cache->hits = 0;
+    cache->misses = 0;
+    cache->evictions = 0;
+}
+
+/* Release all plans, counters kept */
+void clear_plan_cache(plan_cache *cache)
+{
+    unsigned long hits = cache->hits;
+    unsigned long misses = cache->misses;
+    unsigned long evictions = cache->evictions;
+    unsigned int i;
+
+    for (i = 0; i < cache->count_entries; ++i)
+        release_arena(cache->entries[i].plan);
+
+    new_plan_cache(cache);
+    cache->hits = hits;
+    cache->misses = misses;
+    cache->evictions = evictions;
+}
+
+void lru_unlink(plan_cache *cache, int i)
+{
+    plan_entry *e = cache->entries + i;
+
+    if (e->prev == -1)
+        cache->first = e->next;
+    else
+        cache->entries[e->prev].next = e->next;
+
+    if (e->next == -1)
+        cache->last = e->prev;
+    else
+        cache->entries[e->next].prev = e->prev;
+}
+
+void lru_push_front(plan_cache *cache, int i)
+{
+    plan_entry *e = cache->entries + i;
+
+    e->prev = -1;
+    e->next = cache->first;
+    if (cache->first == -1)
+        cache->last = i;
+    else
+        cache->entries[cache->first].prev = i;
+    cache->first = i;
+}
+
+void bucket_unlink(plan_cache *cache, int i)
+{
+    int *cur = cache->buckets + cache->entries[i].hash % PLAN_CACHE_BUCKETS;
+
+    while (*cur != i)
+        cur = &(cache->entries[*cur].bucket_next);
+    *cur = cache->entries[i].bucket_next;
+}
+
+/* Returns tree of plan or NULL. Raw lines
+ * compared, so hash collision is not hit. */
+struct cmd_tree *plan_cache_lookup(plan_cache *cache,
+    unsigned long hash, const char *raw, unsigned int len)
+{
+    int i = cache->buckets[hash % PLAN_CACHE_BUCKETS];
+    plan_entry *e;
+
+    for (; i != -1; i = e->bucket_next) {
+        e = cache->entries + i;
+        if (e->hash == hash && e->len == len
+            && memcmp(e->raw, raw, len) == 0)
+        {
+            ++(cache->hits);
+            if (cache->first != i) {
+                lru_unlink(cache, i);
+                lru_push_front(cache, i);
+            }
+            return e->tree;
+        }
+    }
+
+    ++(cache->misses);
+    return NULL;
+}
+
+/* Cache keeps reference to plan arena.
+ * Least recently used plan evicted, if
+ * cache is full. raw and tree live in plan. */
+void plan_cache_insert(plan_cache *cache, unsigned long hash,
+    char *raw, unsigned int len, struct cmd_tree *tree, arena *plan)
+{
+    int i;
+    plan_entry *e;
+
+    if (cache->count_entries < PLAN_CACHE_SIZE) {
+        i = (cache->count_entries)++;
+    } else {
+        i = cache->last;
+        lru_unlink(cache, i);
+        bucket_unlink(cache, i);
+        release_arena(cache->entries[i].plan);
+        ++(cache->evictions);
+    }
+
+    e = cache->entries + i;
+    e->hash = hash;
+    e->len = len;
+    e->raw = raw;
+    e->tree = tree;
+    e->plan = plan;
+    ref_arena(plan);
+
+    e->bucket_next = cache->buckets[hash % PLAN_CACHE_BUCKETS];
+    cache->buckets[hash % PLAN_CACHE_BUCKETS] = i;
+    lru_push_front(cache, i);
+}
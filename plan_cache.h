@@ -0,0 +1,47 @@
+#ifndef PLAN_CACHE_H_SENTRY
+#define PLAN_CACHE_H_SENTRY
+
+#include "arena.h"
+
+/* Count of cached command lines */
+#ifndef PLAN_CACHE_SIZE
+#define PLAN_CACHE_SIZE 64
+#endif
+
+#define PLAN_CACHE_BUCKETS (PLAN_CACHE_SIZE * 2)
+
+/* Parsed command line. Plan arena holds tree,
+ * copy of raw line and input line with words,
+ * nobody changes it after parsing. */
+typedef struct plan_entry {
+    unsigned long hash;
+    unsigned int len;
+    char *raw;
+    struct cmd_tree *tree;
+    arena *plan;
+    /* Indexes of entries or -1 */
+    int prev; /* more recently used */
+    int next; /* less recently used */
+    int bucket_next;
+} plan_entry;
+
+/* LRU cache of plans keyed by hash of raw line */
+typedef struct plan_cache {
+    plan_entry entries[PLAN_CACHE_SIZE];
+    int buckets[PLAN_CACHE_BUCKETS];
+    unsigned int count_entries;
+    int first; /* most recently used */
+    int last;  /* least recently used */
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long evictions;
+} plan_cache;
+
+void new_plan_cache(plan_cache *cache);
+void clear_plan_cache(plan_cache *cache);
+struct cmd_tree *plan_cache_lookup(plan_cache *cache,
+    unsigned long hash, const char *raw, unsigned int len);
+void plan_cache_insert(plan_cache *cache, unsigned long hash,
+    char *raw, unsigned int len, struct cmd_tree *tree, arena *plan);
+
+#endif
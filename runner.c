@@ -1,12 +1,12 @@
 #include "runner.h"
+#include "utility.h"
 
 /* TODO stdin for "read" (by permissions) operations and stdout for "write" */
 
-void print_job_status(job *j, const char *status)
+void print_job_status(int fd, job *j, const char *status)
 {
-     printf("[id: %d, pgid: %d] (%s ...): %s\n",
-             j->id, j->pgid,
-             *(j->first_process->argv), status);
+     dprintf(fd, "[id: %d, pgid: %d] (%s ...): %s\n",
+             j->id, j->pgid, job_name(j), status);
 }
 
 /* Returns:
@@ -47,17 +47,149 @@ int run_cd(process *p)
 
     /* Change variables */
     new_dir = getcwd(NULL, 0); /* get full path */
-    setenv("OLDPWD", cur_dir, 1);
+    set_shell_var("OLDPWD", cur_dir);
     free(cur_dir);
-    setenv("PWD", new_dir, 1);
+    set_shell_var("PWD", new_dir);
 
     if (print_new_dir)
-        printf("%s\n", new_dir);
+        dprintf(p->fd[1], "%s\n", new_dir);
     free(new_dir);
 
     return 0;
 }
 
+/* Print counters of command line cache,
+ * with -r forget cached plans.
+ * Returns:
+ * 0, on success;
+ * non-zero value, otherwise */
+int run_plans(shell_info *sinfo, process *p)
+{
+    char *arg1 = *(p->argv + 1);
+    plan_cache *cache = sinfo->plans;
+
+    if (arg1 != NULL
+        && (!STR_EQUAL(arg1, "-r") || *(p->argv + 2) != NULL))
+    {
+        fprintf(stderr, "plans: usage: plans [-r]\n");
+        return ES_BUILTIN_CMD_UNCORRECT_ARGS;
+    }
+
+    if (cache == NULL) {
+        fprintf(stderr, "plans: cache disabled\n");
+        return ES_BUILTIN_CMD_ERROR;
+    }
+
+    if (arg1 != NULL) {
+        clear_plan_cache(cache);
+        return 0;
+    }
+
+    dprintf(p->fd[1], "plans: %u of %d cached\n",
+        cache->count_entries, PLAN_CACHE_SIZE);
+    dprintf(p->fd[1], "hits: %lu\nmisses: %lu\nevictions: %lu\n",
+        cache->hits, cache->misses, cache->evictions);
+    return 0;
+}
+
+/* Print launch method of external commands
+ * or set it: fork or spawn.
+ * Returns:
+ * 0, on success;
+ * non-zero value, otherwise */
+int run_launcher(shell_info *sinfo, process *p)
+{
+    char *arg1 = *(p->argv + 1);
+    int method;
+
+    if (arg1 == NULL) {
+        dprintf(p->fd[1], "%s\n", launch_method_name(sinfo->launcher));
+        return 0;
+    }
+
+    method = launch_method_by_name(arg1);
+    if (method == -1 || *(p->argv + 2) != NULL) {
+        fprintf(stderr, "launcher: usage: launcher [fork|spawn]\n");
+        return ES_BUILTIN_CMD_UNCORRECT_ARGS;
+    }
+
+    sinfo->launcher = method;
+    return 0;
+}
+
+/* Print capacity of pipeline pipes or set
+ * it: size in bytes (K and M suffixes allowed)
+ * or "default".
+ * Returns:
+ * 0, on success;
+ * non-zero value, otherwise */
+int run_pipesize(shell_info *sinfo, process *p)
+{
+    char *arg1 = *(p->argv + 1);
+    unsigned long size;
+
+    if (arg1 == NULL) {
+        if (sinfo->pipe_size == 0)
+            dprintf(p->fd[1], "default\n");
+        else
+            dprintf(p->fd[1], "%lu\n", sinfo->pipe_size);
+        return 0;
+    }
+
+    if (*(p->argv + 2) != NULL || (!STR_EQUAL(arg1, "default")
+        && parse_pipe_size(arg1, &size) != 0))
+    {
+        fprintf(stderr, "pipesize: usage: pipesize [size|default]\n");
+        return ES_BUILTIN_CMD_UNCORRECT_ARGS;
+    }
+
+    sinfo->pipe_size = STR_EQUAL(arg1, "default") ? 0 : size;
+    return 0;
+}
+
+/* Print resolved commands with count of
+ * uses, with -r forget them.
+ * Returns:
+ * 0, on success;
+ * non-zero value, otherwise */
+int run_hash(shell_info *sinfo, process *p)
+{
+    char *arg1 = *(p->argv + 1);
+    path_cache *cache = sinfo->paths;
+    path_entry *e;
+    unsigned int i;
+
+    if (arg1 != NULL
+        && (!STR_EQUAL(arg1, "-r") || *(p->argv + 2) != NULL))
+    {
+        fprintf(stderr, "hash: usage: hash [-r]\n");
+        return ES_BUILTIN_CMD_UNCORRECT_ARGS;
+    }
+
+    if (cache == NULL) {
+        fprintf(stderr, "hash: cache disabled\n");
+        return ES_BUILTIN_CMD_ERROR;
+    }
+
+    if (arg1 != NULL) {
+        clear_path_cache(cache);
+        return 0;
+    }
+
+    if (cache->count_entries == 0) {
+        dprintf(p->fd[1], "hash: hash table empty\n");
+        return 0;
+    }
+
+    dprintf(p->fd[1], "hits\tcommand\n");
+    for (i = 0; i < PATH_CACHE_BUCKETS; ++i) {
+        for (e = cache->buckets[i]; e != NULL; e = e->next)
+            dprintf(p->fd[1], "%4lu\t%s\n", e->hits, e->file);
+    }
+
+    return 0;
+}
+
 /* Returns:
  * 0, on success;
  * non-zero value, otherwise */
@@ -71,21 +203,21 @@ int run_jobs(shell_info *sinfo, process *p)
     }
 
     update_jobs_status(sinfo);
-    printf("Jobs list:\n");
+    dprintf(p->fd[1], "Jobs list:\n");
 
     for (j = sinfo->first_job; j != NULL; j = j->next) {
 
         if (j->id == sinfo->cur_job_id) {
             if (job_is_stopped(j)) {
-                print_job_status(j, "stopped; current job");
+                print_job_status(p->fd[1], j, "stopped; current job");
             } else {
-                print_job_status(j, "runned; current job");
+                print_job_status(p->fd[1], j, "runned; current job");
             }
         } else {
             if (job_is_stopped(j)) {
-                print_job_status(j, "stopped");
+                print_job_status(p->fd[1], j, "stopped");
             } else {
-                print_job_status(j, "runned");
+                print_job_status(p->fd[1], j, "runned");
             }
         }
     }
@@ -93,16 +225,22 @@ int run_jobs(shell_info *sinfo, process *p)
     return 0;
 }
 
-void wait_for_job(shell_info *sinfo, job *active_job, int foreground);
+int wait_for_job(shell_info *sinfo, job *active_job, int foreground);
 
 /* Returns:
  * 0, if job continued and (if nessassary) waited
  * 1, on any errors. */
 int continue_job(shell_info *sinfo, job *j, int foreground)
 {
+    /* Non-interactive shell */
+    if (j->pgid == 0) {
+        fprintf(stderr, "bg/fg: no job control.\n");
+        return 1;
+    }
+
     if (sinfo->shell_interactive && foreground
         && TCSETPGRP_ERROR(
-        tcsetpgrp(sinfo->orig_stdin, j->pgid)))
+        tcsetpgrp(STDIN_FILENO, j->pgid)))
     {
         perror("tcsetpgrp()");
         fprintf(stderr, "Possibly, typed job already");
@@ -121,9 +259,9 @@ int continue_job(shell_info *sinfo, job *j, int foreground)
         sinfo->cur_job_id = j->id;
 
     if (sinfo->shell_interactive && !foreground) {
-        print_job_status(j, "continued in background");
+        print_job_status(STDOUT_FILENO, j, "continued in background");
     } else {
-        print_job_status(j, "continued in foreground");
+        print_job_status(STDOUT_FILENO, j, "continued in foreground");
     }
     wait_for_job(sinfo, j, foreground);
 
@@ -138,7 +276,7 @@ int run_bg_fg(shell_info *sinfo, process *p, int foreground)
     job *j;
     int typed_id;
 
-    if (*(p->argv + 2) != NULL) {
+    if (*(p->argv + 1) != NULL && *(p->argv + 2) != NULL) {
         fprintf(stderr, "bg/fg: too many arguments!\n");
         return ES_BUILTIN_CMD_UNCORRECT_ARGS;
     }
@@ -178,18 +316,18 @@ int run_bg_fg(shell_info *sinfo, process *p, int foreground)
     return ES_BUILTIN_CMD_ERROR;
 }
 
-/* Open file, free pipeline->input.
+/* Open file.
  * Returns:
  * fd if all right
  * -1 if error */
-int get_input_fd(cmd_pipeline *pipeline)
+int get_input_fd(cmd_node *pipeline)
 {
     int flags, fd;
 
     if (pipeline->input == NULL)
         return STDIN_FILENO;
 
-    flags = O_RDONLY;
+    flags = O_RDONLY | O_CLOEXEC;
     fd = open(pipeline->input, flags);
 
     if (fd < 0) {
@@ -197,17 +335,14 @@ int get_input_fd(cmd_pipeline *pipeline)
         return -1; /* Error */
     }
 
-    free(pipeline->input);
-    pipeline->input = NULL;
-
     return fd;
 }
 
-/* Open file, free pipeline->output.
+/* Open file.
  * Returns:
  * fd if all right
  * -1 if error */
-int get_output_fd(cmd_pipeline *pipeline)
+int get_output_fd(cmd_node *pipeline)
 {
     int flags, fd;
 
@@ -215,9 +350,9 @@ int get_output_fd(cmd_pipeline *pipeline)
         return STDOUT_FILENO;
 
     if (pipeline->append)
-        flags = O_CREAT | O_WRONLY | O_APPEND;
+        flags = O_CREAT | O_WRONLY | O_APPEND | O_CLOEXEC;
     else
-        flags = O_CREAT | O_WRONLY | O_TRUNC;
+        flags = O_CREAT | O_WRONLY | O_TRUNC | O_CLOEXEC;
 
     fd = open(pipeline->output, flags,
         S_IRUSR | S_IWUSR |
@@ -229,9 +364,6 @@ int get_output_fd(cmd_pipeline *pipeline)
         return -1; /* Error */
     }
 
-    free(pipeline->output);
-    pipeline->output = NULL;
-
     return fd;
 }
 
@@ -239,75 +371,70 @@ int get_output_fd(cmd_pipeline *pipeline)
 
 /* Returns:
  * marked job
- * or NULL, if no job was marked; */
-job *mark_job_status(job *j, pid_t pid, int status)
+ * or NULL, if no job was marked;
+ * Completed process leaves pid index,
+ * so its pid can be reused. */
+job *mark_job_status(shell_info *sinfo, pid_t pid, int status)
 {
     process *p;
 
     if (pid <= 0)
         return NULL;
 
-    for (; j != NULL; j = j->next) {
-        for (p = j->first_process; p != NULL; p = p->next) {
-            if (p->pid == pid) {
-                p->exited = WIFEXITED(status) ? 1 : 0;
-                if (p->exited)
-                    p->exit_status = WEXITSTATUS(status);
-                p->stopped = WIFSTOPPED(status) ? 1 : 0;
-                p->completed = (WIFEXITED(status)
-                    || WIFSIGNALED(status)) ? 1 : 0;
-                return j;
-            }
-        }
-    }
+    p = find_process(sinfo, pid);
+    if (p == NULL)
+        return NULL;
 
-    return NULL;
+    p->exited = WIFEXITED(status) ? 1 : 0;
+    if (p->exited)
+        p->exit_status = WEXITSTATUS(status);
+    else if (WIFSIGNALED(status))
+        p->exit_status = 128 + WTERMSIG(status);
+    else if (WIFSTOPPED(status))
+        p->exit_status = 128 + WSTOPSIG(status);
+    p->stopped = WIFSTOPPED(status) ? 1 : 0;
+    p->completed = (WIFEXITED(status)
+        || WIFSIGNALED(status)) ? 1 : 0;
+    if (p->completed)
+        unindex_process(sinfo, p);
+    return p->job;
 }
 
 /* Blocking until all processes in active job stopped or completed.
- * If active job completed, remove it from list */
-void wait_for_job(shell_info *sinfo, job *active_job, int foreground)
+ * If active job completed, remove it from list.
+ * Returns exit status of job (see job_exit_status()),
+ * 0 for background job. */
+int wait_for_job(shell_info *sinfo, job *active_job, int foreground)
 {
     int status;
-    pid_t pid;
-
-    /* Not runned or runned only built-in commands */
-    if (active_job->pgid == 0)
-        return;
 
-    /* Do wait() only if
-     * (shell not interactive || foreground job) */
-    if (sinfo->shell_interactive && !foreground)
-        return;
+    /* Background jobs reported by update_jobs_status() */
+    if (!foreground)
+        return 0;
 
     /* TODO: setattr */
 
-    /* wait all processes in job */
+    /* Each SIGCHLD reaps all changed children,
+     * background ones reported later */
     do {
-        pid = wait4(WAIT_ANY, &status, WUNTRACED, NULL);
-        if (pid == -1 && errno != ECHILD) {
-            perror("wait4()");
-            exit(ES_SYSCALL_FAILED);
-        }
-
-        if (mark_job_status(sinfo->first_job, pid, status) == NULL) {
+        reap_children(sinfo);
+        if (job_is_stopped(active_job) || job_is_completed(active_job))
             break;
-        }
-        if (job_is_stopped(active_job)) {
-            print_job_status(active_job, "stopped");
-            break;
-        }
-        if (job_is_completed(active_job)) {
-            unregister_job(sinfo, active_job);
-            destroy_job(active_job);
-            break;
-        }
+        wait_sigchld();
     } while (1);
 
-    /* Do tcsetpgrp() only if
-     * (shell interactive && foreground job) */
-    if (!sinfo->shell_interactive || !foreground)
-        return;
+    status = job_exit_status(active_job);
+    if (job_is_completed(active_job)) {
+        unregister_job(sinfo, active_job);
+        destroy_job(active_job);
+    } else {
+        print_job_status(STDOUT_FILENO, active_job, "stopped");
+        active_job->notified = 1;
+    }
+
+    /* Do tcsetpgrp() only if shell interactive */
+    if (!sinfo->shell_interactive)
+        return status;
 
     /* come back terminal permission */
     if (TCSETPGRP_ERROR(
@@ -316,78 +443,85 @@ void wait_for_job(shell_info *sinfo, job *active_job, int foreground)
             perror("(In shell process) tcsetpgrp()");
             exit(ES_SYSCALL_FAILED);
     }
+
+    return status;
 }
 
-/* Update structures without blocking */
-void update_jobs_status(shell_info *sinfo)
+/* Wait for all changed children without
+ * blocking, status applied to their jobs.
+ * Stopped children matter only with job
+ * control. */
+void reap_children(shell_info *sinfo)
 {
+    int options = WNOHANG;
     int status;
     pid_t pid;
     job *j;
 
+    if (sinfo->shell_interactive)
+        options |= WUNTRACED;
+
     do {
-        pid = wait4(WAIT_ANY, &status, WUNTRACED | WNOHANG, NULL);
+        pid = wait4(WAIT_ANY, &status, options, NULL);
+        if (pid == -1 && errno == EINTR)
+            continue;
         if (pid == -1 && errno != ECHILD) {
             perror("wait4()");
             exit(ES_SYSCALL_FAILED);
         }
 
-        j = mark_job_status(sinfo->first_job, pid, status);
-        if (j == NULL)
-            break;
+        /* Not our job (or not one at all) */
+        j = mark_job_status(sinfo, pid, status);
+        if (j != NULL)
+            mark_job_changed(sinfo, j);
+    } while (pid > 0);
+}
+
+/* Report completed jobs (they removed) and
+ * stopped ones (once per stop). Only jobs
+ * changed since last report looked at.
+ * Returns count of reported jobs. */
+int report_jobs(shell_info *sinfo)
+{
+    int count = 0;
+    job *j;
 
+    while ((j = take_changed_job(sinfo)) != NULL) {
         if (job_is_completed(j)) {
-            print_job_status(j, "completed");
+            print_job_status(STDOUT_FILENO, j, "completed");
             unregister_job(sinfo, j);
-            continue;
-        }
-        if (job_is_stopped(j)) {
-            print_job_status(j, "stopped");
-            continue;
+            destroy_job(j);
+            ++count;
+        } else if (job_is_stopped(j) && !j->notified) {
+            print_job_status(STDOUT_FILENO, j, "stopped");
+            j->notified = 1;
+            ++count;
         }
-    } while (1);
+    }
+
+    return count;
 }
 
-/* Replace standart in/out channels,
- * close fd[0] and fd[1] if it not
- * original in/out channels.
- * Keep sinfo->origin_std* actual,
- * see comment in typedef shell_info. */
-void replace_std_channels(shell_info *sinfo, int fd[2])
+/* Returns 1, if report_jobs() has to
+ * report something */
+int has_jobs_to_report(shell_info *sinfo)
 {
-    if (fd[0] == STDIN_FILENO) {
-        if (sinfo->orig_stdin != STDIN_FILENO) {
-            dup2(sinfo->orig_stdin, STDIN_FILENO);
-            close(sinfo->orig_stdin);
-
-            /* Mark that std channel not redirected */
-            sinfo->orig_stdin = STDIN_FILENO;
-        }
-    } else {
-        /* Keep original channel, if necessary */
-        if (sinfo->orig_stdin == STDIN_FILENO)
-            sinfo->orig_stdin = dup(STDIN_FILENO);
+    job *j;
 
-        dup2(fd[0], STDIN_FILENO);
-        close(fd[0]);
+    for (j = sinfo->first_changed_job; j != NULL; j = j->next_changed) {
+        if (job_is_completed(j) || (job_is_stopped(j) && !j->notified))
+            return 1;
     }
 
-    if (fd[1] == STDOUT_FILENO) {
-        if (sinfo->orig_stdout != STDOUT_FILENO) {
-            dup2(sinfo->orig_stdout, STDOUT_FILENO);
-            close(sinfo->orig_stdout);
-
-            /* Mark that std channel not redirected */
-            sinfo->orig_stdout = STDOUT_FILENO;
-        }
-    } else {
-        /* Keep original channel, if necessary */
-        if (sinfo->orig_stdout == STDOUT_FILENO)
-            sinfo->orig_stdout = dup(STDOUT_FILENO);
+    return 0;
+}
 
-        dup2(fd[1], STDOUT_FILENO);
-        close(fd[1]);
-    }
+/* Update structures without blocking */
+void update_jobs_status(shell_info *sinfo)
+{
+    drain_sigchld();
+    reap_children(sinfo);
+    report_jobs(sinfo);
 }
 
 /* Change p->completed to 1, if cmd runned.
@@ -398,6 +532,16 @@ void try_to_run_builtin_cmd(shell_info *sinfo, process *p)
 
     if (STR_EQUAL(*(p->argv), "cd"))
         p->exit_status = run_cd(p);
+    else if (STR_EQUAL(*(p->argv), "plans"))
+        p->exit_status = run_plans(sinfo, p);
+    else if (STR_EQUAL(*(p->argv), "launcher"))
+        p->exit_status = run_launcher(sinfo, p);
+    else if (STR_EQUAL(*(p->argv), "hash"))
+        p->exit_status = run_hash(sinfo, p);
+    else if (STR_EQUAL(*(p->argv), "pipesize"))
+        p->exit_status = run_pipesize(sinfo, p);
+    else if (is_utility(*(p->argv)))
+        p->exit_status = run_utility(p);
     else
         runned = 0;
 
@@ -408,14 +552,17 @@ void try_to_run_builtin_cmd(shell_info *sinfo, process *p)
     }
 }
 
-/* Change j->first_process->completed to 1, if cmd runned or
+/* Change j->processes->completed to 1, if cmd runned or
  * if pipeline contain more then one cmd. In last case set
- * j->first_process->exit_status to ES_BUILTIN_CMD_ERROR.
+ * j->processes->exit_status to ES_BUILTIN_CMD_ERROR.
  * Job control cmd can not be stopped or be uncompleted. */
 void try_to_run_job_control_cmd(shell_info *sinfo, job *j)
 {
     int runned;
-    process *p = j->first_process;
+    process *p = j->processes;
+
+    if (p->argv == NULL || *(p->argv) == NULL)
+        return;
 
     if (!STR_EQUAL(*(p->argv), "jobs")
         && !STR_EQUAL(*(p->argv), "bg")
@@ -425,7 +572,7 @@ void try_to_run_job_control_cmd(shell_info *sinfo, job *j)
         return;
     }
 
-    if (p->next != NULL) {
+    if (j->count_processes > 1) {
         fprintf(stderr, "Job control command");
         fprintf(stderr, " can not be runned as");
         fprintf(stderr, " element of pipeline!\n");
@@ -454,224 +601,727 @@ void try_to_run_job_control_cmd(shell_info *sinfo, job *j)
     }
 }
 
-/* set process group ID
- * set controlling terminal options
- * set job control signals to SIG_DFL
- * exec => no return */
-void launch_process(shell_info *sinfo, process *p,
-        pid_t pgid, int change_foreground_group)
+int is_builtin_cmd(const char *name);
+
+/* Run external command of job with standard
+ * channels p->fd. Not found command fails
+ * without fork. */
+void launch_job_process(shell_info *sinfo, job *j, process *p,
+        int foreground)
 {
-    if (sinfo->shell_interactive) {
-        /* set process group ID
-         * we must make it before tcsetpgrp */
-        if (SETPGID_ERROR(setpgid(p->pid, pgid))) {
-            perror("(In child process) setpgid");
-            exit(ES_SYSCALL_FAILED);
+    launch_info info;
+
+    info.argv = p->argv;
+    info.file = NULL;
+
+    /* Unknown command fails without fork */
+    if (sinfo->paths != NULL) {
+        info.file = path_cache_lookup(sinfo->paths, *(p->argv));
+        if (info.file == NULL) {
+            p->exit_status = EXEC_ERROR_STATUS(errno);
+            if (errno == EACCES)
+                perror(*(p->argv));
+            else
+                fprintf(stderr, "%s: command not found\n", *(p->argv));
+            p->completed = 1;
+            p->exited = 1;
+            return;
         }
+    }
+
+    info.job_control = sinfo->shell_interactive;
+    info.pgid = j->pgid;
+    /* First runned process gives terminal
+     * to group of foreground job */
+    info.tty = (info.job_control && foreground && j->pgid == 0) ?
+        STDIN_FILENO : -1;
+    info.fd[0] = p->fd[0];
+    info.fd[1] = p->fd[1];
+    info.close_fds = j->fds;
+    info.count_close_fds = j->count_fds;
+
+    p->pid = launch_command(sinfo->launcher, &info);
+
+    if (p->pid == -1 && sinfo->launcher == LAUNCH_FORK) {
+        perror("fork");
+        exit(ES_SYSCALL_FAILED);
+    }
 
-        /* we must make in before execvp */
-        if (change_foreground_group
-                && TCSETPGRP_ERROR(
-                tcsetpgrp(sinfo->orig_stdin, pgid)))
+    /* Not found or not executable */
+    if (p->pid == -1) {
+        p->exit_status = EXEC_ERROR_STATUS(errno);
+        perror(*(p->argv));
+        /* Child gave terminal to its
+         * group before exec failed */
+        if (info.tty != -1 && TCSETPGRP_ERROR(
+                tcsetpgrp(info.tty, sinfo->shell_pgid)))
         {
-            perror("(In child process) tcsetpgrp()");
+            perror("(In shell process) tcsetpgrp()");
             exit(ES_SYSCALL_FAILED);
         }
+        p->pid = 0;
+        p->completed = 1;
+        p->exited = 1;
+        return;
+    }
 
-        set_sig_dfl();
+    if (sinfo->shell_interactive
+        && j->pgid == 0)
+    {
+        j->pgid = p->pid;
     }
+}
 
-    execvp(*(p->argv), p->argv);
-    perror("(In child process) execvp");
-    exit(ES_EXEC_ERROR);
+void run_list_process(shell_info *sinfo, job *j, process *p);
+
+/* Fork shell for subshell, list of job or built-in
+ * command in pipeline, it runs as other processes
+ * of job (see launch_info) */
+void launch_job_shell(shell_info *sinfo, job *j, process *p,
+        int foreground)
+{
+    launch_info info;
+
+    info.argv = NULL;
+    info.file = NULL;
+    info.job_control = sinfo->shell_interactive;
+    info.pgid = j->pgid;
+    info.tty = (info.job_control && foreground && j->pgid == 0) ?
+        STDIN_FILENO : -1;
+    info.fd[0] = p->fd[0];
+    info.fd[1] = p->fd[1];
+    info.close_fds = j->fds;
+    info.count_close_fds = j->count_fds;
+
+    p->pid = launch_shell(&info);
+
+    if (FORK_ERROR(p->pid)) {
+        perror("fork");
+        exit(ES_SYSCALL_FAILED);
+    }
+
+    if (FORK_IS_CHILD(p->pid) && p->argv == NULL) {
+        run_list_process(sinfo, j, p);
+        /* No return */
+    }
+
+    if (FORK_IS_CHILD(p->pid)) {
+        /* Installed by prepare_process() */
+        p->fd[0] = STDIN_FILENO;
+        p->fd[1] = STDOUT_FILENO;
+        try_to_run_builtin_cmd(sinfo, p);
+        exit(p->exit_status);
+    }
+
+    if (sinfo->shell_interactive
+        && j->pgid == 0)
+    {
+        j->pgid = p->pid;
+    }
 }
 
+/* Pipes created with close on exec flag, child
+ * gets its ends by dup2(), built-in command
+ * writes to its end. Shell closes ends
+ * as soon as process runned, so reader sees
+ * EOF, when writers completed. */
 void launch_job(shell_info *sinfo, job *j,
         int foreground)
 {
     process *p;
-    pid_t fork_value;
     int pipefd[2];
-    int cur_fd[2];
 
-    for (p = j->first_process; p != NULL; p = p->next) {
+    for (p = j->processes; p < JOB_PROCESSES_END(j); ++p) {
         /* get input from previous process
          * or from file (for first process) */
-        cur_fd[0] = (p == j->first_process) ?
+        p->fd[0] = (p == j->processes) ?
             j->infile : pipefd[0];
 
-        if (p->next != NULL && PIPE_ERROR(pipe(pipefd))) {
-            perror("pipe()");
-            exit(ES_SYSCALL_FAILED);
+        if (p + 1 < JOB_PROCESSES_END(j)) {
+            if (PIPE_ERROR(pipe2(pipefd, O_CLOEXEC))) {
+                perror("pipe2()");
+                exit(ES_SYSCALL_FAILED);
+            }
+            add_job_fd(j, pipefd[0]);
+            add_job_fd(j, pipefd[1]);
+
+            /* Not fatal, pipe works with any size */
+            if (j->pipe_size != 0
+                && set_pipe_size(pipefd[1], j->pipe_size) != 0)
+            {
+                perror("fcntl(F_SETPIPE_SZ)");
+            }
         }
 
         /* put output to next process (to pipe)
          * or to file (for last process) */
-        cur_fd[1] = (p->next == NULL) ?
+        p->fd[1] = (p + 1 == JOB_PROCESSES_END(j)) ?
             j->outfile : pipefd[1];
 
-        replace_std_channels(sinfo, cur_fd);
+        if (p->completed) {
+            /* Substitutions gave no words */
+        } else if (p->argv == NULL || (j->count_processes > 1
+            && (is_utility(*(p->argv)) || (p + 1 < JOB_PROCESSES_END(j)
+            && is_builtin_cmd(*(p->argv))))))
+        {
+            /* Built-in command not blocks shell on
+             * full pipe: utilities and other ones
+             * writing to pipe */
+            fflush(stdout);
+            launch_job_shell(sinfo, j, p, foreground);
+        } else if (is_builtin_cmd(*(p->argv))) {
+            /* Writes to p->fd[1] itself */
+            try_to_run_builtin_cmd(sinfo, p);
+        } else {
+            /* Forked child flushes buffer of
+             * shell again, if exec failed */
+            fflush(stdout);
+            launch_job_process(sinfo, j, p, foreground);
+        }
 
-        try_to_run_builtin_cmd(sinfo, p);
-        if (p->completed)
-            continue;
+        /* pipefd[0] left for next process */
+        close_job_fd(j, p->fd[0]);
+        close_job_fd(j, p->fd[1]);
+    } /* for */
 
-        fork_value = fork();
+    /* Nothing of job left opened in shell */
+    close_job_fds(j);
+}
 
-        if (FORK_ERROR(fork_value)) {
-            perror("fork");
-            exit(ES_SYSCALL_FAILED);
-        }
+/* Open files of pipeline redirections.
+ * Returns:
+ * 0, on success;
+ * -1, on error (no files left opened). */
+int open_job_files(job *j)
+{
+    j->infile = get_input_fd(j->pipeline);
+    if (GET_FD_ERROR(j->infile)) {
+        fprintf(stderr, "Runner: open_job_files(): bad input file.\n");
+        j->infile = STDIN_FILENO;
+        return -1;
+    }
+    if (j->infile != STDIN_FILENO)
+        add_job_fd(j, j->infile);
 
-        /* set p->pid ang pgid for both processes */
-        if (FORK_IS_PARENT(fork_value))
-            p->pid = fork_value;
-        else
-            p->pid = getpid();
+    j->outfile = get_output_fd(j->pipeline);
+    if (GET_FD_ERROR(j->outfile)) {
+        fprintf(stderr, "Runner: open_job_files(): bad output file.\n");
+        close_job_fds(j);
+        j->infile = STDIN_FILENO;
+        j->outfile = STDOUT_FILENO;
+        return -1;
+    }
+    if (j->outfile != STDOUT_FILENO)
+        add_job_fd(j, j->outfile);
+
+    return 0;
+}
+
+/* Set pipe capacity of job: from pipesize
+ * option or from PIPESIZE=size word before
+ * first command, which removed from argv.
+ * Returns:
+ * 0, on success;
+ * -1, on bad size or no command after it. */
+int take_pipe_size(shell_info *sinfo, job *j)
+{
+    process *p = j->processes;
+
+    j->pipe_size = sinfo->pipe_size;
 
-        if (sinfo->shell_interactive
-            && j->pgid == 0)
+    if (p->argv == NULL || *(p->argv) == NULL
+        || !IS_PIPE_SIZE_WORD(*(p->argv)))
+        return 0;
+
+    if (parse_pipe_size(*(p->argv) + sizeof(PIPE_SIZE_WORD) - 1,
+        &(j->pipe_size)) != 0 || *(p->argv + 1) == NULL)
+    {
+        fprintf(stderr, "%s: bad pipe size or no command\n",
+            *(p->argv));
+        return -1;
+    }
+
+    ++(p->argv);
+    return 0;
+}
+
+/* Choose id, first that not used by other jobs.
+ * Id starts from 1. */
+void choose_job_id(shell_info *sinfo, job *new_job, int foreground)
+{
+    new_job->id = alloc_job_id(sinfo);
+
+    if (!sinfo->shell_interactive || foreground)
+        sinfo->cur_job_id = new_job->id;
+}
+
+/* Returns 1, if all pipelines of list are
+ * built-in commands (except job control ones
+ * and ones clearing caches of shell) or such
+ * subshells, so list can be runned without
+ * fork, 0 otherwise. */
+int is_builtin_list(cmd_tree *tree, cmd_node *list)
+{
+    cmd_node *pipeline, *item;
+    unsigned int i;
+
+    for (i = 0; i < list->count; ++i) {
+        pipeline = CMD_NODE_CHILD(tree, list, i);
+        if (pipeline->count != 1
+            || pipeline->input != NULL || pipeline->output != NULL)
         {
-            j->pgid = p->pid;
+            return 0;
         }
 
-        if (FORK_IS_CHILD(fork_value)) {
-            if (p->next != NULL)
-                close(pipefd[0]); /* used by next process */
-            /* pipefd[1] == cur_fd[1], already closed */
-            launch_process(sinfo, p, j->pgid,
-                    sinfo->shell_interactive
-                    && foreground
-                    && p == j->first_process);
-            /* No return */
+        item = CMD_NODE_CHILD(tree, pipeline, 0);
+        if (item->type == NODE_CMD && item->count != 0) {
+            /* Substitutions forked anyway */
+            return 0;
+        } else if (item->type == NODE_SUBSHELL) {
+            if (!is_builtin_list(tree, CMD_NODE_CHILD(tree, item, 0)))
+                return 0;
+        } else if (!is_builtin_cmd(*(item->argv))
+            || STR_EQUAL(*(item->argv), "bg")
+            || STR_EQUAL(*(item->argv), "fg")
+            || STR_EQUAL(*(item->argv), "plans")
+            || STR_EQUAL(*(item->argv), "hash"))
+        {
+            return 0;
         }
+    }
 
-        /* parent process (here and next) */
-        if (sinfo->shell_interactive) {
-            /* set process group ID
-             * we must make it before tcsetpgrp
-             * for job */
-            if (SETPGID_ERROR(setpgid(p->pid, j->pgid))) {
-                perror("(In child process) setpgid");
-                exit(ES_SYSCALL_FAILED);
-            }
-        }
-    } /* for */
+    return 1;
+}
+
+int run_list_node(shell_info *sinfo, cmd_tree *tree, cmd_node *list,
+        int exec_last);
+
+/* Run subshell of built-in commands (see
+ * is_builtin_list()) in shell process.
+ * Current directory, environment and options
+ * of shell restored after it.
+ * Returns exit status of list or -1, if
+ * current directory can not be saved. */
+int run_subshell_in_shell(shell_info *sinfo, cmd_tree *tree,
+        cmd_node *list)
+{
+    launch_method saved_launcher = sinfo->launcher;
+    unsigned long saved_pipe_size = sinfo->pipe_size;
+    environ_state saved_environ;
+    int dir_fd;
+    int status;
+
+    dir_fd = open(".", O_RDONLY | O_CLOEXEC);
+    if (dir_fd == -1)
+        return -1;
+    save_environ(&saved_environ);
 
-    cur_fd[0] = STDIN_FILENO;
-    cur_fd[1] = STDOUT_FILENO;
-    replace_std_channels(sinfo, cur_fd);
+    status = run_list_node(sinfo, tree, list, 0);
+
+    if (CHDIR_ERROR(fchdir(dir_fd)))
+        perror("fchdir()");
+    close(dir_fd);
+    restore_environ(&saved_environ);
+    /* Options of `launcher` and `pipesize` */
+    sinfo->launcher = saved_launcher;
+    sinfo->pipe_size = saved_pipe_size;
+
+    return status;
 }
 
-job *pipeline_to_job(cmd_pipeline *pipeline)
+void forget_jobs(shell_info *sinfo);
+
+/* Run list of substitution by forked shell with
+ * output to pipe, last simple command of list
+ * exec'd. Output read to buf.
+ * Returns exit status of list. */
+int run_substitution(shell_info *sinfo, cmd_tree *tree,
+        cmd_node *subst, buffer *buf)
 {
-    cmd_pipeline_item *scmd = NULL;
-    job *j = make_job();
-    process *p = NULL;
+    char chunk[SUBST_READ_SIZE];
+    launch_info info;
+    int pipefd[2];
+    int status;
+    long res;
+    pid_t pid;
 
-    for (scmd = pipeline->first_item; scmd != NULL;
-            scmd = scmd->next)
-    {
-        if (p == NULL) {
-            j->first_process = p =
-                pipeline_item_to_process(scmd);
-        } else {
-            p = p->next =
-                pipeline_item_to_process(scmd);
-        }
+    if (PIPE_ERROR(pipe2(pipefd, O_CLOEXEC))) {
+        perror("pipe2()");
+        exit(ES_SYSCALL_FAILED);
     }
 
-    /* TODO: maybe, make redirections in child process?
-     * But it will be not works for built-in commands */
+    info.argv = NULL;
+    info.file = NULL;
+    info.job_control = 0;
+    info.pgid = 0;
+    info.tty = -1;
+    info.fd[0] = STDIN_FILENO;
+    info.fd[1] = pipefd[1];
+    info.close_fds = pipefd;
+    info.count_close_fds = 1;
+
+    fflush(stdout);
+    pid = launch_shell(&info);
+
+    if (FORK_ERROR(pid)) {
+        perror("fork");
+        exit(ES_SYSCALL_FAILED);
+    }
 
-    j->infile = get_input_fd(pipeline);
-    if (GET_FD_ERROR(j->infile)) {
-        fprintf(stderr, "Runner: pipeline_to_job(): bad input file.\n");
-        /* TODO: goto error, free() */
-        return NULL;
+    if (FORK_IS_CHILD(pid)) {
+        /* In group of shell, so signals
+         * from terminal must kill it */
+        if (sinfo->shell_interactive)
+            set_sig_dfl();
+        forget_jobs(sinfo);
+        exit(run_list_node(sinfo, tree, CMD_NODE_CHILD(tree, subst, 0), 1));
     }
 
-    j->outfile = get_output_fd(pipeline);
-    if (GET_FD_ERROR(j->outfile)) {
-        fprintf(stderr, "Runner: pipeline_to_job(): bad output file.\n");
-        /* TODO: goto error, free() */
-        return NULL;
+    close(pipefd[1]);
+    do {
+        res = read(pipefd[0], chunk, sizeof(chunk));
+        if (res > 0)
+            add_chars_to_buffer(buf, chunk, res);
+    } while (res > 0 || (res == -1 && errno == EINTR));
+    if (res == -1)
+        perror("read()");
+    close(pipefd[0]);
+
+    while (waitpid(pid, &status, 0) == -1) {
+        if (errno != EINTR) {
+            perror("waitpid()");
+            exit(ES_SYSCALL_FAILED);
+        }
     }
 
-    /* Items already freed in loop */
-    /* Strings for input/output files already freed in get_*_fd() */
-    free(pipeline);
+    return WIFEXITED(status) ? WEXITSTATUS(status)
+        : 128 + WTERMSIG(status);
+}
+
+/* Current field (if begun) becomes word of argv */
+void end_field(field_info *field)
+{
+    unsigned int len = field->text.count_sym;
+    char *str;
+    char *word;
+
+    if (!field->begun)
+        return;
 
-    return j;
+    str = convert_to_string(&field->text, 1);
+    word = (char *) arena_alloc(field->arena, len + 1);
+    memcpy(word, str, len + 1);
+    free(str);
+    add_to_word_buffer(field->wbuf, word);
+    field->begun = 0;
 }
 
-/* Choose id, first that not used by other jobs.
- * Id starts from 1. */
-void choose_job_id(shell_info *sinfo, job *new_job, int foreground)
+/* Split output of substitution by blanks and
+ * newlines to fields, trailing newlines
+ * stripped. First field continues current
+ * one, last one left current, so words
+ * joined with substitution are joined with
+ * its output. */
+void split_to_fields(field_info *field, buffer *out)
 {
-    job *j;
-    int id_in_use;
+    unsigned int len = out->count_sym;
+    char *str = convert_to_string(out, 1);
+    unsigned int i, run;
 
-    new_job->id = 0;
+    while (len > 0 && str[len - 1] == '\n')
+        --len;
 
-    do {
-        ++(new_job->id);
-        id_in_use = 0;
-        for (j = sinfo->first_job;
-                !id_in_use && j != NULL;
-                j = j->next)
+    for (i = 0; i < len; i += run) {
+        for (run = 0; i + run < len && str[i + run] != ' '
+            && str[i + run] != '\t' && str[i + run] != '\n'; ++run)
         {
-            id_in_use = (j->id == new_job->id);
+            /* Empty */
         }
-    } while (id_in_use);
 
-    if (!sinfo->shell_interactive || foreground)
-        sinfo->cur_job_id = new_job->id;
+        if (run == 0) {
+            end_field(field);
+            run = 1;
+        } else {
+            add_chars_to_buffer(&field->text, str + i, run);
+            field->begun = 1;
+        }
+    }
+
+    free(str);
+}
+
+/* Make argv of command with substitutions,
+ * fields of their output in place of them.
+ * Process without words completed with
+ * status of last substitution. */
+void substitute_process(shell_info *sinfo, cmd_tree *tree, process *p)
+{
+    cmd_node *subst = CMD_NODE_CHILD(tree, p->cmd, 0);
+    cmd_node *end = CMD_NODE_CHILD(tree, p->cmd, p->cmd->count);
+    char **argv = p->cmd->argv;
+    /* Word joined to previous substitution */
+    int joined = 0;
+    word_buffer wbuf;
+    field_info field;
+    buffer out;
+    unsigned int i;
+
+    new_word_buffer(&wbuf, tree->arena);
+    field.wbuf = &wbuf;
+    field.arena = tree->arena;
+    new_buffer(&field.text);
+    field.begun = 0;
+    new_buffer(&out);
+
+    for (i = 0; argv[i] != NULL; ++i) {
+        if (subst < end && subst->word == i) {
+            if (!subst->join_prev)
+                end_field(&field);
+            p->exit_status = run_substitution(sinfo, tree, subst, &out);
+            split_to_fields(&field, &out);
+            joined = subst->join_next;
+            ++subst;
+            continue;
+        }
+
+        if (!joined)
+            end_field(&field);
+
+        if (joined || (subst < end && subst->word == i + 1
+            && subst->join_prev))
+        {
+            add_chars_to_buffer(&field.text, argv[i], strlen(argv[i]));
+            field.begun = 1;
+        } else {
+            add_to_word_buffer(&wbuf, argv[i]);
+        }
+        joined = 0;
+    }
+
+    end_field(&field);
+    clear_buffer(&field.text);
+    clear_buffer(&out);
+    p->completed = p->exited = (wbuf.count_words == 0);
+    p->argv = convert_to_argv(&wbuf, 1);
+}
+
+/* Substitutions of job runned one by one
+ * before its processes */
+void substitute_job(shell_info *sinfo, job *j)
+{
+    process *p;
+
+    for (p = j->processes; p < JOB_PROCESSES_END(j); ++p) {
+        if (p->argv != NULL && p->cmd->count != 0)
+            substitute_process(sinfo, j->tree, p);
+    }
 }
 
-/* TODO: lists */
-void run_cmd_list(shell_info *sinfo, cmd_list *list)
+/* Returns exit status of pipeline, 0 for
+ * background one */
+int run_pipeline(shell_info *sinfo, cmd_tree *tree,
+        cmd_node *node, int foreground)
 {
-    cmd_list_item *cur_item;
+    cmd_node *item = CMD_NODE_CHILD(tree, node, 0);
+    int status;
     job *j;
 
-    if (list->first_item->rel != REL_NONE) {
-        fprintf(stderr, "Runner: run_cmd_list():\
-currently command lists not implemented.\n");
-        return;
+    /* Subshell is only stage, so no fork */
+    if (foreground && node->type == NODE_PIPELINE && node->count == 1
+        && item->type == NODE_SUBSHELL && node->input == NULL
+        && node->output == NULL
+        && is_builtin_list(tree, CMD_NODE_CHILD(tree, item, 0)))
+    {
+        status = run_subshell_in_shell(sinfo, tree,
+            CMD_NODE_CHILD(tree, item, 0));
+        if (status != -1)
+            return status;
     }
 
-    for (cur_item = list->first_item;
-        cur_item != NULL;
-        cur_item = cur_item->next)
+    j = make_job(tree, node);
+    substitute_job(sinfo, j);
+
+    if (take_pipe_size(sinfo, j) != 0) {
+        destroy_job(j);
+        return ES_BUILTIN_CMD_UNCORRECT_ARGS;
+    }
+
+    /* We not redirect input/output for
+     * job control commands */
+    try_to_run_job_control_cmd(sinfo, j);
+    if (job_is_completed(j)) {
+        status = job_exit_status(j);
+        destroy_job(j);
+        return status;
+    }
+
+    if (open_job_files(j) != 0) {
+        destroy_job(j);
+        return ES_BUILTIN_CMD_ERROR;
+    }
+
+    launch_job(sinfo, j, foreground);
+
+    /* Only built-in commands or commands
+     * not spawned, nothing to wait */
+    if (job_is_completed(j)) {
+        status = job_exit_status(j);
+        destroy_job(j);
+        return status;
+    }
+
+    choose_job_id(sinfo, j, foreground);
+    register_job(sinfo, j);
+    if (sinfo->shell_interactive && !foreground)
+        print_job_status(STDOUT_FILENO, j, "launched in background");
+    return wait_for_job(sinfo, j, foreground);
+}
+
+/* Returns 1, if pipeline is one external
+ * command (not subshell and not built-in
+ * command), 0 otherwise. */
+int is_external_pipeline(cmd_tree *tree, cmd_node *pipeline)
+{
+    cmd_node *scmd = CMD_NODE_CHILD(tree, pipeline, 0);
+
+    if (pipeline->count != 1 || scmd->type != NODE_CMD
+        || scmd->count != 0)
     {
-        j = pipeline_to_job(cur_item->pl);
-        if (j == NULL)
-            return;
+        return 0;
+    }
+
+    return !is_builtin_cmd(*(scmd->argv))
+        && !IS_PIPE_SIZE_WORD(*(scmd->argv));
+}
 
-        /* We not redirect input/output for
-         * job control commands */
-        try_to_run_job_control_cmd(sinfo, j);
-        if (job_is_completed(j) ||
-            j->first_process->exit_status != 0)
+/* Replace shell process by command (see
+ * is_external_pipeline()) without fork.
+ * Returns exit status, if redirections
+ * failed or command not found. */
+int exec_pipeline(shell_info *sinfo, cmd_tree *tree, cmd_node *pipeline)
+{
+    launch_info info;
+
+    info.argv = CMD_NODE_CHILD(tree, pipeline, 0)->argv;
+    info.file = NULL;
+    if (sinfo->paths != NULL) {
+        info.file = path_cache_lookup(sinfo->paths, *(info.argv));
+        if (info.file == NULL && errno == EACCES) {
+            perror(*(info.argv));
+            return ES_EXEC_DENIED;
+        }
+        if (info.file == NULL) {
+            fprintf(stderr, "%s: command not found\n", *(info.argv));
+            return ES_EXEC_ERROR;
+        }
+    }
+
+    info.job_control = 0;
+    info.close_fds = NULL;
+    info.count_close_fds = 0;
+
+    /* Opened with close on exec flag */
+    info.fd[0] = get_input_fd(pipeline);
+    if (GET_FD_ERROR(info.fd[0]))
+        return ES_BUILTIN_CMD_ERROR;
+    info.fd[1] = get_output_fd(pipeline);
+    if (GET_FD_ERROR(info.fd[1]))
+        return ES_BUILTIN_CMD_ERROR;
+
+    fflush(stdout);
+    prepare_process(&info);
+    launch_process(&info);
+    return ES_EXEC_ERROR; /* Not reached */
+}
+
+/* Run pipelines of list one by one: next one
+ * runned after ';', after '&&' if status is
+ * 0 and after '||' if it is not 0, otherwise
+ * skipped with its relation. If exec_last,
+ * last external command replaces shell.
+ * Returns exit status of last runned pipeline. */
+int run_cmd_list(shell_info *sinfo, cmd_tree *tree, cmd_node *list,
+        int foreground, int exec_last)
+{
+    cmd_node *pipeline;
+    int status = 0;
+    int run = 1;
+    unsigned int i;
+
+    for (i = 0; i < list->count; ++i) {
+        pipeline = CMD_NODE_CHILD(tree, list, i);
+
+        if (run && exec_last && foreground && i + 1 == list->count
+            && is_external_pipeline(tree, pipeline))
         {
-            destroy_job(j);
-            j = NULL;
-            continue;
+            status = exec_pipeline(sinfo, tree, pipeline);
+        } else if (run) {
+            status = run_pipeline(sinfo, tree, pipeline, foreground);
         }
 
-        launch_job(sinfo, j, list->foreground);
-        choose_job_id(sinfo, j, list->foreground);
-        register_job(sinfo, j);
-        if (sinfo->shell_interactive && !list->foreground)
-            print_job_status(j, "launched in background");
-        wait_for_job(sinfo, j, list->foreground);
-
-        /*
-        if ((cur_item->rel == REL_NONE)
-            || (cur_item->rel == REL_OR && j->status != 0)
-            || (cur_item->rel == REL_AND && j->status == 0))
-            break;
-        */
-    } while (cur_item != NULL); /* to be on the safe side */
+        run = (pipeline->rel == REL_AND) ? (status == 0)
+            : (pipeline->rel == REL_OR) ? (status != 0)
+            : 1;
+    }
+
+    return status;
+}
+
+/* Jobs of parent shell are not our
+ * in forked shell */
+void forget_jobs(shell_info *sinfo)
+{
+    sinfo->shell_interactive = 0;
+    sinfo->first_job = NULL;
+    sinfo->last_job = NULL;
+    sinfo->cur_job_id = 0;
+    clear_job_tables(sinfo);
+    init_sigchld();
+}
+
+/* Code of forked shell, which runs subshell
+ * or list of background job => no return.
+ * Last external command of it exec'd. */
+void run_list_process(shell_info *sinfo, job *j, process *p)
+{
+    forget_jobs(sinfo);
+
+    if (p->cmd->type == NODE_SUBSHELL) {
+        exit(run_list_node(sinfo, j->tree,
+            CMD_NODE_CHILD(j->tree, p->cmd, 0), 1));
+    }
+
+    exit(run_cmd_list(sinfo, j->tree, p->cmd, 1, 1));
+}
+
+/* List of several pipelines in background
+ * runned by forked shell as one job.
+ * Returns exit status of list. */
+int run_list_node(shell_info *sinfo, cmd_tree *tree, cmd_node *list,
+        int exec_last)
+{
+    if (!list->foreground && list->count > 1)
+        return run_pipeline(sinfo, tree, list, 0);
+
+    return run_cmd_list(sinfo, tree, list, list->foreground, exec_last);
+}
+
+/* Root list runned directly from tree nodes */
+int run_cmd_tree(shell_info *sinfo, cmd_tree *tree, int exec_last)
+{
+    return run_list_node(sinfo, tree, CMD_TREE_ROOT(tree), exec_last);
+}
+
+/* Names of commands, which runned by shell itself */
+int is_builtin_cmd(const char *name)
+{
+    return STR_EQUAL(name, "cd")
+        || STR_EQUAL(name, "plans")
+        || STR_EQUAL(name, "launcher")
+        || STR_EQUAL(name, "hash")
+        || STR_EQUAL(name, "pipesize")
+        || is_utility(name)
+        || STR_EQUAL(name, "jobs")
+        || STR_EQUAL(name, "bg")
+        || STR_EQUAL(name, "fg");
 }
@@ -6,6 +6,11 @@
  * 127 is default value for bash. */
 #define ES_EXEC_ERROR 127
 
+/* Exit status, if command found, but
+ * not executable (exec failed with
+ * EACCES), as in bash. */
+#define ES_EXEC_DENIED 126
+
 /* Exit status, if built-in command found,
  * but arguments incorrect.
  * 2 is default value for bash. */
@@ -21,6 +26,12 @@
 #define ES_SYSCALL_FAILED 1
 
 #define STR_EQUAL(str1, str2) (strcmp((str1), (str2)) == 0)
+
+/* First word of pipeline, which overrides
+ * pipesize option: PIPESIZE=1M cmd | cmd */
+#define PIPE_SIZE_WORD "PIPESIZE="
+#define IS_PIPE_SIZE_WORD(str) \
+    (strncmp((str), PIPE_SIZE_WORD, sizeof(PIPE_SIZE_WORD) - 1) == 0)
 #define CHDIR_ERROR(chdir_value) ((chdir_value) == -1)
 #define GET_FD_ERROR(get_fd_value) ((get_fd_value) == -1)
 #define SETPGID_ERROR(setpgid_value) ((setpgid_value) == -1)
@@ -31,12 +42,17 @@
 #define PIPE_SUCCESS(pipe_value) ((pipe_value) == 0)
 #define PIPE_ERROR(pipe_value) ((pipe_value) == -1)
 #define KILL_ERROR(kill_value) ((kill_value) == -1)
+#define DUP2_ERROR(dup2_value) ((dup2_value) == -1)
+#define EXEC_ERROR_STATUS(exec_errno) \
+    ((exec_errno) == EACCES ? ES_EXEC_DENIED : ES_EXEC_ERROR)
 
-/* for setenv() and wait4() */
-#define _BSD_SOURCE
+/* Output of substitution read by such chunks */
+#ifndef SUBST_READ_SIZE
+#define SUBST_READ_SIZE 65536
+#endif
 
-/* for kill() */
-#define _POSIX_C_SOURCE 1
+/* for setenv(), wait4(), kill() and pipe2() */
+#define _GNU_SOURCE
 
 #include <stdlib.h>
 #include <sys/types.h>
@@ -51,55 +67,156 @@
 #include <string.h>
 
 #include "parser.h"
+#include "buffer.h"
+#include "word_buffer.h"
+#include "launcher.h"
+#include "path_cache.h"
 
+/* State of running command of job */
 typedef struct process {
+    /* NODE_CMD, NODE_SUBSHELL or NODE_LIST
+     * of job, both runned by forked shell */
+    cmd_node *cmd;
+    /* Packed copy of cmd->argv (words of
+     * substitutions added at run), NULL if
+     * not NODE_CMD */
     char **argv;
+    /* Standard input and output:
+     * descriptors of shell */
+    int fd[2];
     pid_t pid;
     unsigned int completed:1;
     unsigned int stopped:1;
     unsigned int exited:1;
     int exit_status;
     /* exit_status correct, if process
-     * completed */
-    struct process *next;
+     * completed or stopped: 128 + number
+     * of signal, if killed or stopped */
+    struct job *job;
+    /* Next process in bucket of pid index */
+    struct process *next_by_pid;
 } process;
 
+/* Job runs pipeline node of command tree,
+ * one process per child of the node, or
+ * background list node in one process */
 typedef struct job {
-    process *first_process;
+    cmd_tree *tree;
+    cmd_node *pipeline;
+    process *processes;
+    unsigned int count_processes;
     pid_t pgid;
     int id;
-/* Nessessary?
+    /* Stop of job reported */
     unsigned int notified:1;
-*/
+    /* In changed_jobs of shell_info */
+    unsigned int changed:1;
 /* Not compiled with it
     struct termious tmodes;
 */
     int infile;
     int outfile;
+    /* Descriptors opened by shell for the
+     * job: files and pipes. Each closed as
+     * soon as its processes runned, -1 then. */
+    int *fds;
+    unsigned int count_fds;
+    /* Capacity of pipes, 0 for default */
+    unsigned long pipe_size;
+    /* Arena with tree, job itself,
+     * processes, argv and its words */
+    arena *arena;
+    struct job *prev;
     struct job *next;
+    struct job *next_changed;
 } job;
 
+#define JOB_PROCESSES_END(j) ((j)->processes + (j)->count_processes)
+
+/* Initial count of buckets of pid index,
+ * power of 2 */
+#ifndef PID_INDEX_BUCKETS
+#define PID_INDEX_BUCKETS 64
+#endif
+
+/* Bucket of pid in index of shell_info */
+#define PID_BUCKET(sinfo, pid) \
+    ((sinfo)->pid_buckets + ((unsigned int) (pid) \
+        & ((sinfo)->count_pid_buckets - 1)))
+
+/* Job ids in word of bitmap */
+#define JOB_IDS_WORD_BITS (sizeof(unsigned long) * 8)
+
+/* Word of argv made of words of command and
+ * output of substitutions joined with them
+ * (see substitute_process()) */
+typedef struct field_info {
+    word_buffer *wbuf;
+    /* Words of argv copied to it */
+    arena *arena;
+    buffer text;
+    /* Field begun, maybe empty ("") */
+    unsigned int begun:1;
+} field_info;
+
+/* Initial size of list of variables
+ * owned by shell (see set_shell_var()) */
+#ifndef SHELL_VARS_SIZE
+#define SHELL_VARS_SIZE 8
+#endif
+
+/* Environment before subshell runned in
+ * shell process (see save_environ()) */
+typedef struct environ_state {
+    /* Copy of environ array, not strings */
+    char **vars;
+    /* Mark of outer saved environment */
+    unsigned int shell_vars_mark;
+} environ_state;
+
 typedef struct shell_info {
     char **envp;
     pid_t shell_pgid;
     unsigned int shell_interactive:1;
-    int orig_stdin;
-    /* == STDIN_FILENO, if standart
-     * input channel not redirected,
-     * != STDIN_FILENO, otherwise.
-     * This values changed by
-     * replace_std_channels(). */
-    int orig_stdout;
-    /* Similary with STDOUT_FILENO */
     job *first_job;
     job *last_job;
     int cur_job_id;
+    /* Jobs with reaped processes since last
+     * report_jobs(), in order of reaping */
+    job *first_changed_job;
+    job *last_changed_job;
+    /* Runned and not completed processes of
+     * registered jobs by pid: hash table,
+     * count of buckets is power of 2 and
+     * grows with count of processes */
+    process **pid_buckets;
+    unsigned int count_pid_buckets;
+    unsigned int count_pids;
+    /* Bitmap of used job ids, bit id - 1,
+     * and first word with free bit */
+    unsigned long *job_ids;
+    unsigned int count_job_ids_words;
+    unsigned int free_job_ids_word;
+    /* Cache of parsed command lines,
+     * NULL if disabled */
+    plan_cache *plans;
+    /* fork() or posix_spawnp(),
+     * see `launcher` builtin */
+    launch_method launcher;
+    /* Capacity of pipeline pipes, 0 for
+     * default, see `pipesize` builtin */
+    unsigned long pipe_size;
+    /* Resolved command names,
+     * NULL if disabled */
+    path_cache *paths;
 } shell_info;
 
 #include "utils.h"
 
-void run_cmd_list(shell_info *sinfo,
-        cmd_list *list);
+int run_cmd_tree(shell_info *sinfo, cmd_tree *tree, int exec_last);
+void reap_children(shell_info *sinfo);
+int report_jobs(shell_info *sinfo);
+int has_jobs_to_report(shell_info *sinfo);
 void update_jobs_status(shell_info *sinfo);
 
 #endif
@@ -0,0 +1,106 @@
+#include <stdlib.h>
+
+#include "scan.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) \
+    && !defined(SCAN_SCALAR_ONLY)
+#define SCAN_X86
+#include <immintrin.h>
+#endif
+
+/* Symbols, which end plain run of word:
+ * delimiters, quote and backslash. */
+static const char special_symbols[] = " \t\n<>|&;()`\"\\";
+
+#define COUNT_SPECIAL_SYMBOLS (sizeof(special_symbols) - 1)
+
+static unsigned char special_table[256];
+
+static unsigned int (*scan_impl)(const char *str, unsigned int len);
+
+unsigned int scan_word_run_scalar(const char *str, unsigned int len)
+{
+    unsigned int i = 0;
+
+    while (i < len && !special_table[(unsigned char) str[i]])
+        ++i;
+
+    return i;
+}
+
+#ifdef SCAN_X86
+
+__attribute__((target("sse2")))
+unsigned int scan_word_run_sse2(const char *str, unsigned int len)
+{
+    unsigned int i = 0;
+    unsigned int j;
+    int mask;
+    __m128i block, found;
+
+    for (; i + 16 <= len; i += 16) {
+        block = _mm_loadu_si128((const __m128i *) (str + i));
+        found = _mm_setzero_si128();
+        for (j = 0; j < COUNT_SPECIAL_SYMBOLS; ++j) {
+            found = _mm_or_si128(found, _mm_cmpeq_epi8(block,
+                _mm_set1_epi8(special_symbols[j])));
+        }
+        mask = _mm_movemask_epi8(found);
+        if (mask != 0)
+            return i + __builtin_ctz(mask);
+    }
+
+    return i + scan_word_run_scalar(str + i, len - i);
+}
+
+__attribute__((target("avx2")))
+unsigned int scan_word_run_avx2(const char *str, unsigned int len)
+{
+    unsigned int i = 0;
+    unsigned int j;
+    unsigned int mask;
+    __m256i block, found;
+
+    for (; i + 32 <= len; i += 32) {
+        block = _mm256_loadu_si256((const __m256i *) (str + i));
+        found = _mm256_setzero_si256();
+        for (j = 0; j < COUNT_SPECIAL_SYMBOLS; ++j) {
+            found = _mm256_or_si256(found, _mm256_cmpeq_epi8(block,
+                _mm256_set1_epi8(special_symbols[j])));
+        }
+        mask = (unsigned int) _mm256_movemask_epi8(found);
+        if (mask != 0)
+            return i + __builtin_ctz(mask);
+    }
+
+    return i + scan_word_run_sse2(str + i, len - i);
+}
+
+#endif
+
+/* Choose implementation on first call */
+void init_scan(void)
+{
+    unsigned int i;
+
+    for (i = 0; i < COUNT_SPECIAL_SYMBOLS; ++i)
+        special_table[(unsigned char) special_symbols[i]] = 1;
+
+    scan_impl = scan_word_run_scalar;
+
+#ifdef SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        scan_impl = scan_word_run_avx2;
+    else if (__builtin_cpu_supports("sse2"))
+        scan_impl = scan_word_run_sse2;
+#endif
+}
+
+unsigned int scan_word_run(const char *str, unsigned int len)
+{
+    if (scan_impl == NULL)
+        init_scan();
+
+    return scan_impl(str, len);
+}
@@ -0,0 +1,13 @@
+#ifndef SCAN_H_SENTRY
+#define SCAN_H_SENTRY
+
+/* SCAN_SCALAR_ONLY disables SSE2/AVX2
+ * code even on x86. */
+
+/* Returns count of symbols from begin of str,
+ * which have no special meaning in unquoted
+ * word (see st_word()). Uses SSE2 or AVX2,
+ * if processor supports it. */
+unsigned int scan_word_run(const char *str, unsigned int len);
+
+#endif
@@ -0,0 +1,32 @@
+#!/bin/sh
+# Backquote substitution joined with text next to it,
+# runned by `make test` after shell.
+
+SHELL_FILE=./shell
+failed=0
+
+# check command expected: arguments printed as [arg]
+check()
+{
+    got=`$SHELL_FILE -c "$1"`
+    if [ "$got" != "$2" ]; then
+        echo "FAIL: $1"
+        echo "  expected: $2"
+        echo "  got:      $got"
+        failed=1
+    fi
+}
+
+P=/usr/bin/printf
+
+check "$P [%s] pre\`echo mid\`post" '[premidpost]'
+check "$P [%s] \`printf \"x\\n\\n\\n\"\`END" '[xEND]'
+check "$P [%s] a\`true\`b" '[ab]'
+check "$P [%s] a\`echo 1 2\`b c" '[a1][2b][c]'
+check "$P [%s] \`echo x\`\`echo y\` z" '[xy][z]'
+check "$P [%s] \"q r\"\`echo s\`" '[q rs]'
+check "$P [%s] \`echo a\` \`echo b\`" '[a][b]'
+check "$P [%s] x \`echo\` y" '[x][y]'
+
+[ $failed = 0 ] && echo "Substitution: all passed"
+exit $failed
@@ -0,0 +1,717 @@
+#include "utility.h"
+
+#include <stdarg.h>
+
+#define IS_OCTAL(c) ((c) >= '0' && (c) <= '7')
+
+/* Write whole buffer to fd, buffer emptied.
+ * Returns exit status of utility. */
+int write_buffer(int fd, buffer *buf, const char *name)
+{
+    unsigned int len = buf->count_sym;
+    char *str = convert_to_string(buf, 1);
+    unsigned int done = 0;
+    int status = 0;
+    long res;
+
+    while (done < len) {
+        res = write(fd, str + done, len - done);
+        if (res == -1 && errno == EINTR)
+            continue;
+        if (res == -1) {
+            perror(name);
+            status = 1;
+            break;
+        }
+        done += res;
+    }
+
+    free(str);
+    return status;
+}
+
+/* Append escape sequence, *s points to its
+ * backslash and left on its last symbol.
+ * Octal is \0nnn in echo and %b, \nnn in
+ * format of printf.
+ * Returns 1, if \c met: output must stop. */
+int add_escape(buffer *buf, const char **s, int zero_octal)
+{
+    const char *digits;
+    int c;
+    int i;
+
+    ++(*s);
+    switch (**s) {
+    case 'a':
+        c = '\a';
+        break;
+    case 'b':
+        c = '\b';
+        break;
+    case 'c':
+        return 1;
+    case 'f':
+        c = '\f';
+        break;
+    case 'n':
+        c = '\n';
+        break;
+    case 'r':
+        c = '\r';
+        break;
+    case 't':
+        c = '\t';
+        break;
+    case 'v':
+        c = '\v';
+        break;
+    case '\\':
+        c = '\\';
+        break;
+    case '\0':
+        /* Backslash at end kept */
+        --(*s);
+        c = '\\';
+        break;
+    default:
+        if (zero_octal ? **s == '0' : IS_OCTAL(**s)) {
+            digits = zero_octal ? *s + 1 : *s;
+            c = 0;
+            for (i = 0; i < 3 && IS_OCTAL(digits[i]); ++i)
+                c = c * 8 + (digits[i] - '0');
+            *s = digits + i - 1;
+        } else {
+            add_to_buffer(buf, '\\');
+            c = **s;
+        }
+        break;
+    }
+
+    add_to_buffer(buf, c);
+    return 0;
+}
+
+/* Returns 1, if \c met */
+int add_escaped(buffer *buf, const char *str)
+{
+    const char *s;
+
+    for (s = str; *s != '\0'; ++s) {
+        if (*s != '\\')
+            add_to_buffer(buf, *s);
+        else if (add_escape(buf, &s, 1))
+            return 1;
+    }
+
+    return 0;
+}
+
+/* echo [-n] [string ...]
+ * Escape sequences replaced (as XSI echo
+ * does), -n or \c suppress newline. */
+int run_echo(process *p)
+{
+    char **arg = p->argv + 1;
+    int newline = 1;
+    buffer buf;
+
+    if (*arg != NULL && STR_EQUAL(*arg, "-n")) {
+        newline = 0;
+        ++arg;
+    }
+
+    new_buffer(&buf);
+    for (; *arg != NULL; ++arg) {
+        if (add_escaped(&buf, *arg)) {
+            newline = 0;
+            break;
+        }
+        if (*(arg + 1) != NULL)
+            add_to_buffer(&buf, ' ');
+    }
+
+    if (newline)
+        add_to_buffer(&buf, '\n');
+
+    return write_buffer(p->fd[1], &buf, "echo");
+}
+
+/* Append output of vsnprintf() */
+void add_formatted(buffer *buf, const char *spec, ...)
+{
+    char small[256];
+    char *str = small;
+    va_list args;
+    int len;
+
+    va_start(args, spec);
+    len = vsnprintf(small, sizeof(small), spec, args);
+    va_end(args);
+
+    if (len < 0)
+        return;
+
+    if ((unsigned int) len >= sizeof(small)) {
+        str = (char *) malloc(len + 1);
+        va_start(args, spec);
+        vsnprintf(str, len + 1, spec, args);
+        va_end(args);
+    }
+
+    add_chars_to_buffer(buf, str, len);
+    if (str != small)
+        free(str);
+}
+
+/* Next argument of printf or NULL,
+ * if arguments ended */
+char *printf_arg(char ***arg)
+{
+    if (**arg == NULL)
+        return NULL;
+    return *((*arg)++);
+}
+
+/* Numeric argument of printf: number or 'c
+ * (and "c) for code of c, 0 if absent. Bad
+ * number reported, its valid prefix used. */
+long printf_number(const char *arg, int *status)
+{
+    char *end;
+    long value;
+
+    if (arg == NULL)
+        return 0;
+
+    if (*arg == '\'' || *arg == '"')
+        return (unsigned char) arg[1];
+
+    errno = 0;
+    value = strtol(arg, &end, 0);
+    if (end == arg || *end != '\0' || errno == ERANGE) {
+        fprintf(stderr, "printf: %s: invalid number\n", arg);
+        *status = 1;
+    }
+
+    return value;
+}
+
+double printf_double(const char *arg, int *status)
+{
+    char *end;
+    double value;
+
+    if (arg == NULL)
+        return 0;
+
+    if (*arg == '\'' || *arg == '"')
+        return (unsigned char) arg[1];
+
+    value = strtod(arg, &end);
+    if (end == arg || *end != '\0') {
+        fprintf(stderr, "printf: %s: invalid number\n", arg);
+        *status = 1;
+    }
+
+    return value;
+}
+
+/* Copy width or precision of conversion to spec,
+ * '*' taken from argument.
+ * Returns new length of spec. */
+unsigned int printf_width(char *spec, unsigned int len,
+        const char **s, char ***arg, int *status)
+{
+    unsigned int digits = 0;
+
+    if (**s == '*') {
+        ++(*s);
+        sprintf(spec + len, "%d",
+            (int) printf_number(printf_arg(arg), status));
+        return len + strlen(spec + len);
+    }
+
+    while (**s >= '0' && **s <= '9') {
+        /* Longer width is not sane */
+        if (digits++ < 9)
+            spec[len++] = **s;
+        ++(*s);
+    }
+
+    return len;
+}
+
+/* Output format once, arguments of conversions
+ * taken from *arg (missing are empty or 0).
+ * Returns 1, if output must stop: \c in
+ * format or %b or bad conversion. */
+int printf_format(buffer *buf, const char *format, char ***arg,
+        int *status)
+{
+    char spec[PRINTF_SPEC_SIZE];
+    unsigned int len;
+    const char *s;
+    char *value;
+    char *str;
+    char first[2];
+    buffer escaped;
+    int stop;
+
+    for (s = format; *s != '\0'; ++s) {
+        if (*s == '\\') {
+            if (add_escape(buf, &s, 0))
+                return 1;
+            continue;
+        }
+
+        if (*s != '%') {
+            add_to_buffer(buf, *s);
+            continue;
+        }
+
+        if (*(s + 1) == '%') {
+            add_to_buffer(buf, '%');
+            ++s;
+            continue;
+        }
+
+        len = 0;
+        spec[len++] = '%';
+        for (++s; *s != '\0' && strchr("-+ #0", *s) != NULL; ++s) {
+            if (len < 8)
+                spec[len++] = *s;
+        }
+        len = printf_width(spec, len, &s, arg, status);
+        if (*s == '.') {
+            spec[len++] = *(s++);
+            len = printf_width(spec, len, &s, arg, status);
+        }
+
+        switch (*s) {
+        case 'd':
+        case 'i':
+            spec[len++] = 'l';
+            spec[len++] = *s;
+            spec[len] = '\0';
+            add_formatted(buf, spec,
+                printf_number(printf_arg(arg), status));
+            break;
+        case 'o':
+        case 'u':
+        case 'x':
+        case 'X':
+            spec[len++] = 'l';
+            spec[len++] = *s;
+            spec[len] = '\0';
+            add_formatted(buf, spec,
+                (unsigned long) printf_number(printf_arg(arg), status));
+            break;
+        case 'e':
+        case 'E':
+        case 'f':
+        case 'g':
+        case 'G':
+            spec[len++] = *s;
+            spec[len] = '\0';
+            add_formatted(buf, spec,
+                printf_double(printf_arg(arg), status));
+            break;
+        case 'c':
+            value = printf_arg(arg);
+            first[0] = (value == NULL) ? '\0' : *value;
+            first[1] = '\0';
+            spec[len++] = 's';
+            spec[len] = '\0';
+            add_formatted(buf, spec, first);
+            break;
+        case 's':
+            value = printf_arg(arg);
+            spec[len++] = 's';
+            spec[len] = '\0';
+            add_formatted(buf, spec, (value == NULL) ? "" : value);
+            break;
+        case 'b':
+            value = printf_arg(arg);
+            new_buffer(&escaped);
+            stop = add_escaped(&escaped, (value == NULL) ? "" : value);
+            str = convert_to_string(&escaped, 1);
+            spec[len++] = 's';
+            spec[len] = '\0';
+            add_formatted(buf, spec, str);
+            free(str);
+            if (stop)
+                return 1;
+            break;
+        default:
+            if (*s == '\0')
+                fprintf(stderr, "printf: %s: missing conversion\n", spec);
+            else
+                fprintf(stderr, "printf: %%%c: invalid conversion\n", *s);
+            *status = 1;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/* printf format [argument ...]
+ * Format reused while arguments left. */
+int run_printf(process *p)
+{
+    char **arg;
+    char **start;
+    buffer buf;
+    int status = 0;
+    int stop;
+
+    if (*(p->argv + 1) == NULL) {
+        fprintf(stderr, "printf: usage: printf format [arguments]\n");
+        return ES_BUILTIN_CMD_UNCORRECT_ARGS;
+    }
+
+    new_buffer(&buf);
+    arg = p->argv + 2;
+    do {
+        start = arg;
+        stop = printf_format(&buf, *(p->argv + 1), &arg, &status);
+    } while (!stop && *arg != NULL && arg != start);
+
+    if (write_buffer(p->fd[1], &buf, "printf") != 0)
+        return 1;
+    return status;
+}
+
+int test_is_unary(const char *op)
+{
+    return op[0] == '-' && op[1] != '\0' && op[2] == '\0'
+        && strchr("bcdefghLnprsStuwxz", op[1]) != NULL;
+}
+
+int test_is_binary(const char *op)
+{
+    return STR_EQUAL(op, "=") || STR_EQUAL(op, "!=")
+        || STR_EQUAL(op, "-eq") || STR_EQUAL(op, "-ne")
+        || STR_EQUAL(op, "-gt") || STR_EQUAL(op, "-ge")
+        || STR_EQUAL(op, "-lt") || STR_EQUAL(op, "-le");
+}
+
+long test_integer(test_info *ti, const char *str)
+{
+    char *end;
+    long value;
+
+    errno = 0;
+    value = strtol(str, &end, 10);
+    while (*end == ' ' || *end == '\t')
+        ++end;
+
+    if (end == str || *end != '\0' || errno == ERANGE) {
+        fprintf(stderr, "%s: %s: integer expression expected\n",
+            ti->name, str);
+        ti->error = 1;
+    }
+
+    return value;
+}
+
+int test_unary(test_info *ti, const char *op, const char *arg)
+{
+    struct stat st;
+    int res;
+
+    switch (op[1]) {
+    case 'n':
+        return *arg != '\0';
+    case 'z':
+        return *arg == '\0';
+    case 't':
+        return isatty((int) test_integer(ti, arg));
+    case 'r':
+        return access(arg, R_OK) == 0;
+    case 'w':
+        return access(arg, W_OK) == 0;
+    case 'x':
+        return access(arg, X_OK) == 0;
+    case 'h':
+    case 'L':
+        res = lstat(arg, &st);
+        return res == 0 && S_ISLNK(st.st_mode);
+    default:
+        break;
+    }
+
+    if (stat(arg, &st) != 0)
+        return 0;
+
+    switch (op[1]) {
+    case 'b':
+        return S_ISBLK(st.st_mode);
+    case 'c':
+        return S_ISCHR(st.st_mode);
+    case 'd':
+        return S_ISDIR(st.st_mode);
+    case 'f':
+        return S_ISREG(st.st_mode);
+    case 'g':
+        return (st.st_mode & S_ISGID) != 0;
+    case 'p':
+        return S_ISFIFO(st.st_mode);
+    case 's':
+        return st.st_size > 0;
+    case 'S':
+        return S_ISSOCK(st.st_mode);
+    case 'u':
+        return (st.st_mode & S_ISUID) != 0;
+    default: /* 'e' */
+        return 1;
+    }
+}
+
+int test_binary(test_info *ti, const char *left, const char *op,
+        const char *right)
+{
+    long a, b;
+
+    if (STR_EQUAL(op, "="))
+        return STR_EQUAL(left, right);
+    if (STR_EQUAL(op, "!="))
+        return !STR_EQUAL(left, right);
+
+    a = test_integer(ti, left);
+    b = test_integer(ti, right);
+
+    if (STR_EQUAL(op, "-eq"))
+        return a == b;
+    if (STR_EQUAL(op, "-ne"))
+        return a != b;
+    if (STR_EQUAL(op, "-gt"))
+        return a > b;
+    if (STR_EQUAL(op, "-ge"))
+        return a >= b;
+    if (STR_EQUAL(op, "-lt"))
+        return a < b;
+    return a <= b;
+}
+
+int test_or(test_info *ti);
+
+/* primary: ( expr ) | word binary word |
+ *          unary word | word */
+int test_primary(test_info *ti)
+{
+    char **argv = ti->argv + ti->pos;
+    unsigned int left = ti->count - ti->pos;
+    int result;
+
+    if (left == 0) {
+        fprintf(stderr, "%s: argument expected\n", ti->name);
+        ti->error = 1;
+        return 0;
+    }
+
+    if (left >= 3 && test_is_binary(argv[1])) {
+        ti->pos += 3;
+        return test_binary(ti, argv[0], argv[1], argv[2]);
+    }
+
+    if (left >= 2 && STR_EQUAL(argv[0], "(")) {
+        ++(ti->pos);
+        result = test_or(ti);
+        if (ti->pos == ti->count || !STR_EQUAL(ti->argv[ti->pos], ")")) {
+            if (!ti->error)
+                fprintf(stderr, "%s: ')' expected\n", ti->name);
+            ti->error = 1;
+        } else {
+            ++(ti->pos);
+        }
+        return result;
+    }
+
+    if (left >= 2 && test_is_unary(argv[0])) {
+        ti->pos += 2;
+        return test_unary(ti, argv[0], argv[1]);
+    }
+
+    ++(ti->pos);
+    return *(argv[0]) != '\0';
+}
+
+/* not: ! not | primary
+ * "! = word" is comparison of "!" */
+int test_not(test_info *ti)
+{
+    unsigned int left = ti->count - ti->pos;
+
+    if (left >= 2 && STR_EQUAL(ti->argv[ti->pos], "!")
+        && !(left >= 3 && test_is_binary(ti->argv[ti->pos + 1])))
+    {
+        ++(ti->pos);
+        return !test_not(ti);
+    }
+
+    return test_primary(ti);
+}
+
+/* and: not [-a not ...] */
+int test_and(test_info *ti)
+{
+    int result = test_not(ti);
+
+    while (!ti->error && ti->pos < ti->count
+        && STR_EQUAL(ti->argv[ti->pos], "-a"))
+    {
+        ++(ti->pos);
+        result = test_not(ti) && result;
+    }
+
+    return result;
+}
+
+/* expr: and [-o and ...] */
+int test_or(test_info *ti)
+{
+    int result = test_and(ti);
+
+    while (!ti->error && ti->pos < ti->count
+        && STR_EQUAL(ti->argv[ti->pos], "-o"))
+    {
+        ++(ti->pos);
+        result = test_and(ti) || result;
+    }
+
+    return result;
+}
+
+/* test expression, [ expression ]
+ * Returns 0, if expression true, 1, if
+ * false or empty, ES_TEST_ERROR on error. */
+int run_test(process *p)
+{
+    test_info ti;
+    int result;
+
+    ti.name = *(p->argv);
+    ti.argv = p->argv + 1;
+    ti.count = 0;
+    ti.pos = 0;
+    ti.error = 0;
+
+    while (ti.argv[ti.count] != NULL)
+        ++(ti.count);
+
+    if (STR_EQUAL(ti.name, "[")) {
+        if (ti.count == 0 || !STR_EQUAL(ti.argv[ti.count - 1], "]")) {
+            fprintf(stderr, "[: missing ]\n");
+            return ES_TEST_ERROR;
+        }
+        --(ti.count);
+    }
+
+    if (ti.count == 0)
+        return 1;
+
+    result = test_or(&ti);
+    if (!ti.error && ti.pos < ti.count) {
+        fprintf(stderr, "%s: %s: unexpected operator\n",
+            ti.name, ti.argv[ti.pos]);
+        ti.error = 1;
+    }
+
+    if (ti.error)
+        return ES_TEST_ERROR;
+    return result ? 0 : 1;
+}
+
+/* Returns 1, if pwd is absolute name of
+ * current directory without . and .. */
+int is_logical_pwd(const char *pwd)
+{
+    struct stat st_pwd, st_cur;
+    const char *s;
+
+    if (pwd == NULL || *pwd != '/')
+        return 0;
+
+    for (s = pwd; *s != '\0'; ++s) {
+        if (*s == '/' && *(s + 1) == '.'
+            && (*(s + 2) == '/' || *(s + 2) == '\0'
+                || (*(s + 2) == '.'
+                    && (*(s + 3) == '/' || *(s + 3) == '\0'))))
+        {
+            return 0;
+        }
+    }
+
+    return stat(pwd, &st_pwd) == 0 && stat(".", &st_cur) == 0
+        && st_pwd.st_dev == st_cur.st_dev
+        && st_pwd.st_ino == st_cur.st_ino;
+}
+
+/* pwd [-L|-P]
+ * Logical: PWD, if it is valid. */
+int run_pwd(process *p)
+{
+    const char *pwd = getenv("PWD");
+    int physical = 0;
+    char **arg;
+    char *dir;
+    buffer buf;
+
+    for (arg = p->argv + 1; *arg != NULL; ++arg) {
+        if (STR_EQUAL(*arg, "-L")) {
+            physical = 0;
+        } else if (STR_EQUAL(*arg, "-P")) {
+            physical = 1;
+        } else {
+            fprintf(stderr, "pwd: usage: pwd [-L|-P]\n");
+            return ES_BUILTIN_CMD_UNCORRECT_ARGS;
+        }
+    }
+
+    new_buffer(&buf);
+    if (!physical && is_logical_pwd(pwd)) {
+        add_chars_to_buffer(&buf, pwd, strlen(pwd));
+    } else {
+        dir = getcwd(NULL, 0);
+        if (dir == NULL) {
+            perror("pwd");
+            return ES_BUILTIN_CMD_ERROR;
+        }
+        add_chars_to_buffer(&buf, dir, strlen(dir));
+        free(dir);
+    }
+    add_to_buffer(&buf, '\n');
+
+    return write_buffer(p->fd[1], &buf, "pwd");
+}
+
+int is_utility(const char *name)
+{
+    return STR_EQUAL(name, "echo")
+        || STR_EQUAL(name, "printf")
+        || STR_EQUAL(name, "true")
+        || STR_EQUAL(name, "false")
+        || STR_EQUAL(name, "test")
+        || STR_EQUAL(name, "[")
+        || STR_EQUAL(name, "pwd");
+}
+
+/* Returns exit status of utility */
+int run_utility(process *p)
+{
+    const char *name = *(p->argv);
+
+    if (STR_EQUAL(name, "echo"))
+        return run_echo(p);
+    if (STR_EQUAL(name, "printf"))
+        return run_printf(p);
+    if (STR_EQUAL(name, "true"))
+        return 0;
+    if (STR_EQUAL(name, "false"))
+        return 1;
+    if (STR_EQUAL(name, "test") || STR_EQUAL(name, "["))
+        return run_test(p);
+    return run_pwd(p);
+}
@@ -0,0 +1,37 @@
+#ifndef UTILITY_H_SENTRY
+#define UTILITY_H_SENTRY
+
+/* Standard utilities built in shell: they not
+ * change shell state, so can run in forked
+ * shell as well (see launch_job()). Output
+ * collected in buffer and written to p->fd[1]
+ * by one write(). */
+
+#include "runner.h"
+
+/* Exit status of test on bad expression */
+#define ES_TEST_ERROR 2
+
+/* Room for conversion of printf format:
+ * flags, width, precision and type */
+#define PRINTF_SPEC_SIZE 64
+
+/* Parsing state of test expression */
+typedef struct test_info {
+    /* "test" or "[" for messages */
+    const char *name;
+    char **argv;
+    unsigned int count;
+    unsigned int pos;
+    int error;
+} test_info;
+
+int is_utility(const char *name);
+int run_utility(process *p);
+
+int run_echo(process *p);
+int run_printf(process *p);
+int run_test(process *p);
+int run_pwd(process *p);
+
+#endif
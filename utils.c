@@ -1,21 +1,39 @@
+/* For environ */
+#define _GNU_SOURCE
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <signal.h>
+#include <poll.h>
 
 #include "utils.h"
 
+/* Self-pipe of SIGCHLD, see init_sigchld() */
+int sigchld_pipe[2] = { -1, -1 };
+
 void new_shell_info(shell_info *sinfo)
 {
     /* sinfo = (shell_info *) malloc(sizeof(shell_info)); */
     sinfo->envp = NULL;
     sinfo->shell_pgid = 0;
     sinfo->shell_interactive = 0;
-    sinfo->orig_stdin = STDIN_FILENO;
-    sinfo->orig_stdout = STDOUT_FILENO;
     sinfo->first_job = NULL;
     sinfo->last_job = NULL;
     sinfo->cur_job_id = 0;
+    sinfo->first_changed_job = NULL;
+    sinfo->last_changed_job = NULL;
+    /* Allocated by first registered job */
+    sinfo->pid_buckets = NULL;
+    sinfo->count_pid_buckets = 0;
+    sinfo->count_pids = 0;
+    sinfo->job_ids = NULL;
+    sinfo->count_job_ids_words = 0;
+    sinfo->free_job_ids_word = 0;
+    sinfo->plans = NULL;
+    sinfo->launcher = LAUNCH_FORK;
+    sinfo->paths = NULL;
+    sinfo->pipe_size = 0;
 }
 
 void set_sig_ign(void)
@@ -39,6 +57,66 @@ void set_sig_dfl(void)
     signal(SIGTTOU, SIG_DFL);
 }
 
+void sigchld_handler(int sig)
+{
+    int saved_errno = errno;
+
+    /* Pipe full means wakeup pending */
+    write(sigchld_pipe[1], "", 1);
+    errno = saved_errno;
+}
+
+/* Handler of SIGCHLD writes byte to self-pipe,
+ * waits and main loop poll its read end and
+ * then reap children. Forked shell (not
+ * exec'd) makes its own pipe. */
+void init_sigchld(void)
+{
+    struct sigaction sa;
+
+    if (sigchld_pipe[0] != -1) {
+        close(sigchld_pipe[0]);
+        close(sigchld_pipe[1]);
+    }
+
+    if (PIPE_ERROR(pipe2(sigchld_pipe, O_CLOEXEC | O_NONBLOCK))) {
+        perror("pipe2()");
+        exit(ES_SYSCALL_FAILED);
+    }
+
+    sa.sa_handler = sigchld_handler;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART;
+    if (sigaction(SIGCHLD, &sa, NULL) == -1) {
+        perror("sigaction()");
+        exit(ES_SYSCALL_FAILED);
+    }
+}
+
+/* Block until SIGCHLD came after last
+ * drain_sigchld() */
+void wait_sigchld(void)
+{
+    struct pollfd pfd;
+
+    pfd.fd = sigchld_pipe[0];
+    pfd.events = POLLIN;
+    while (poll(&pfd, 1, -1) == -1 && errno == EINTR) {
+        /* Empty */
+    }
+
+    drain_sigchld();
+}
+
+void drain_sigchld(void)
+{
+    char buf[64];
+
+    while (read(sigchld_pipe[0], buf, sizeof(buf)) > 0) {
+        /* Empty */
+    }
+}
+
 void print_prompt1(void)
 {
     char *ps1 = getenv("PS1");
@@ -95,29 +173,83 @@ void print_set(char **envp)
 /* =========== */
 /* Job control */
 
-/* convert pipeline_item to process,
- * free pipeline_item */
-process *pipeline_item_to_process(cmd_pipeline_item *simple_cmd)
+/* Copy argv to one block: table of pointers
+ * and then strings. Child after fork touches
+ * only dense pages of it. */
+char **pack_argv(arena *a, char **argv)
 {
-    process *p;
-    if (simple_cmd == NULL)
+    unsigned int count = 0;
+    unsigned int size = 0;
+    unsigned int len;
+    char **packed;
+    char *str;
+
+    if (argv == NULL)
         return NULL;
-    p = (process *) malloc(sizeof(process));
-    p->argv = simple_cmd->argv;
-    free(simple_cmd);
+
+    while (argv[count] != NULL)
+        size += strlen(argv[count++]) + 1;
+
+    packed = (char **) arena_alloc(a,
+        sizeof(char *) * (count + 1) + size);
+    str = (char *) (packed + count + 1);
+
+    for (count = 0; argv[count] != NULL; ++count) {
+        len = strlen(argv[count]) + 1;
+        memcpy(str, argv[count], len);
+        packed[count] = str;
+        str += len;
+    }
+
+    packed[count] = NULL;
+    return packed;
+}
+
+/* Process of command node, argv packed
+ * to arena of job */
+void init_process(process *p, arena *a, cmd_node *cmd)
+{
+    p->cmd = cmd;
+    /* One allocation, freed with arena */
+    p->argv = pack_argv(a, cmd->argv);
+    p->fd[0] = STDIN_FILENO;
+    p->fd[1] = STDOUT_FILENO;
     p->pid = 0; /* Not runned */
     p->completed = 0;
     p->stopped = 0;
     p->exited = 0;
     p->exit_status = 0;
-    p->next = NULL;
-    return p;
+    p->job = NULL;
+    p->next_by_pid = NULL;
 }
 
-job *make_job()
+/* Job for pipeline node of tree or for list
+ * node, runned by one forked shell. Job lives
+ * in arena of its command line and keeps it
+ * while not destroyed. */
+job *make_job(cmd_tree *tree, cmd_node *pipeline)
 {
-    job *j = (job *) malloc(sizeof(job));
-    j->first_process = NULL;
+    arena *a = tree->arena;
+    job *j = (job *) arena_alloc(a, sizeof(job));
+    unsigned int i;
+
+    j->tree = tree;
+    j->pipeline = pipeline;
+    j->count_processes = (pipeline->type == NODE_LIST) ?
+        1 : pipeline->count;
+    j->processes = (process *) arena_alloc(a,
+        sizeof(process) * j->count_processes);
+    if (pipeline->type == NODE_LIST) {
+        init_process(j->processes, a, pipeline);
+    } else {
+        for (i = 0; i < pipeline->count; ++i) {
+            init_process(j->processes + i, a,
+                CMD_NODE_CHILD(tree, pipeline, i));
+        }
+    }
+    for (i = 0; i < j->count_processes; ++i)
+        j->processes[i].job = j;
+
     j->pgid = 0;
     /* j->pgid == 0 if job not runned
      * or runned only built-in commands */
@@ -128,58 +260,260 @@ job *make_job()
     /* j->notified = 0; */
     j->infile = STDIN_FILENO;
     j->outfile = STDOUT_FILENO;
+    /* Two files and pipes between processes */
+    j->fds = (int *) arena_alloc(a,
+        sizeof(int) * 2 * (j->count_processes + 1));
+    j->count_fds = 0;
+    j->pipe_size = 0;
+    j->notified = 0;
+    j->changed = 0;
+    j->arena = a;
+    ref_arena(a);
+    j->prev = NULL;
     j->next = NULL;
+    j->next_changed = NULL;
     return j;
 }
 
+/* Job, processes and argv freed
+ * with arena, if it last user. */
 void destroy_job(job *j)
 {
-    process *next;
-    process *p = j->first_process;
+    release_arena(j->arena);
+}
+
+/* Double count of buckets of pid index
+ * (or allocate it), processes rehashed */
+void grow_pid_index(shell_info *sinfo)
+{
+    process **old_buckets = sinfo->pid_buckets;
+    unsigned int old_count = sinfo->count_pid_buckets;
+    process *p, *next, **bucket;
+    unsigned int i;
+
+    sinfo->count_pid_buckets = (old_count == 0) ?
+        PID_INDEX_BUCKETS : 2 * old_count;
+    sinfo->pid_buckets = (process **) malloc(sizeof(process *)
+        * sinfo->count_pid_buckets);
+    for (i = 0; i < sinfo->count_pid_buckets; ++i)
+        sinfo->pid_buckets[i] = NULL;
+
+    for (i = 0; i < old_count; ++i) {
+        for (p = old_buckets[i]; p != NULL; p = next) {
+            next = p->next_by_pid;
+            bucket = PID_BUCKET(sinfo, p->pid);
+            p->next_by_pid = *bucket;
+            *bucket = p;
+        }
+    }
+
+    free(old_buckets);
+}
+
+/* Add runned process to pid index */
+void index_process(shell_info *sinfo, process *p)
+{
+    process **bucket;
+
+    if (sinfo->count_pids >= sinfo->count_pid_buckets)
+        grow_pid_index(sinfo);
+
+    /* Newer process with reused pid found first */
+    bucket = PID_BUCKET(sinfo, p->pid);
+    p->next_by_pid = *bucket;
+    *bucket = p;
+    ++(sinfo->count_pids);
+}
+
+/* Remove process from pid index, if it there */
+void unindex_process(shell_info *sinfo, process *p)
+{
+    process **cur;
+
+    if (sinfo->count_pids == 0)
+        return;
+
+    for (cur = PID_BUCKET(sinfo, p->pid); *cur != NULL;
+        cur = &((*cur)->next_by_pid))
+    {
+        if (*cur == p) {
+            *cur = p->next_by_pid;
+            p->next_by_pid = NULL;
+            --(sinfo->count_pids);
+            return;
+        }
+    }
+}
+
+/* Returns process of registered job
+ * or NULL, if pid is not our */
+process *find_process(shell_info *sinfo, pid_t pid)
+{
+    process *p;
+
+    if (sinfo->count_pids == 0)
+        return NULL;
+
+    for (p = *PID_BUCKET(sinfo, pid); p != NULL; p = p->next_by_pid) {
+        if (p->pid == pid)
+            return p;
+    }
+
+    return NULL;
+}
+
+/* Returns first id, not used by other jobs.
+ * Id starts from 1. */
+int alloc_job_id(shell_info *sinfo)
+{
+    unsigned int i = sinfo->free_job_ids_word;
+    unsigned int bit;
+
+    while (i < sinfo->count_job_ids_words && sinfo->job_ids[i] == ~0UL)
+        ++i;
+
+    if (i == sinfo->count_job_ids_words) {
+        sinfo->count_job_ids_words = (i == 0) ? 1 : 2 * i;
+        sinfo->job_ids = (unsigned long *) realloc(sinfo->job_ids,
+            sizeof(unsigned long) * sinfo->count_job_ids_words);
+        memset(sinfo->job_ids + i, 0, sizeof(unsigned long)
+            * (sinfo->count_job_ids_words - i));
+    }
+
+    for (bit = 0; sinfo->job_ids[i] & (1UL << bit); ++bit)
+        ;
+
+    sinfo->job_ids[i] |= 1UL << bit;
+    sinfo->free_job_ids_word = i;
+    return i * JOB_IDS_WORD_BITS + bit + 1;
+}
+
+void free_job_id(shell_info *sinfo, int id)
+{
+    unsigned int i = (id - 1) / JOB_IDS_WORD_BITS;
+
+    sinfo->job_ids[i] &= ~(1UL << ((id - 1) % JOB_IDS_WORD_BITS));
+    if (i < sinfo->free_job_ids_word)
+        sinfo->free_job_ids_word = i;
+}
+
+/* Add job to end of changed jobs, if not yet */
+void mark_job_changed(shell_info *sinfo, job *j)
+{
+    if (j->changed)
+        return;
+
+    j->changed = 1;
+    j->next_changed = NULL;
+    if (sinfo->first_changed_job == NULL)
+        sinfo->last_changed_job = sinfo->first_changed_job = j;
+    else
+        sinfo->last_changed_job = sinfo->last_changed_job->next_changed = j;
+}
+
+/* Returns first of changed jobs or NULL,
+ * it removed from them */
+job *take_changed_job(shell_info *sinfo)
+{
+    job *j = sinfo->first_changed_job;
+
+    if (j == NULL)
+        return NULL;
+
+    sinfo->first_changed_job = j->next_changed;
+    if (sinfo->first_changed_job == NULL)
+        sinfo->last_changed_job = NULL;
+    j->changed = 0;
+    j->next_changed = NULL;
+    return j;
+}
+
+/* Remove job from changed jobs, if it there.
+ * List is short: jobs reaped since prompt. */
+void unmark_job_changed(shell_info *sinfo, job *j)
+{
+    job *prev_j = NULL;
+    job *cur_j;
 
-    while (p != NULL) {
-        next = p->next;
-        free(p->argv);
-        free(p);
-        p = next;
+    if (!j->changed)
+        return;
+
+    for (cur_j = sinfo->first_changed_job; cur_j != j;
+        cur_j = cur_j->next_changed)
+    {
+        prev_j = cur_j;
     }
 
-    free(j);
+    if (prev_j == NULL)
+        sinfo->first_changed_job = j->next_changed;
+    else
+        prev_j->next_changed = j->next_changed;
+
+    if (sinfo->last_changed_job == j)
+        sinfo->last_changed_job = prev_j;
+
+    j->changed = 0;
+    j->next_changed = NULL;
 }
 
+/* Forget pid index and job ids, jobs
+ * itself not destroyed */
+void clear_job_tables(shell_info *sinfo)
+{
+    free(sinfo->pid_buckets);
+    free(sinfo->job_ids);
+    sinfo->pid_buckets = NULL;
+    sinfo->count_pid_buckets = 0;
+    sinfo->count_pids = 0;
+    sinfo->job_ids = NULL;
+    sinfo->count_job_ids_words = 0;
+    sinfo->free_job_ids_word = 0;
+    sinfo->first_changed_job = NULL;
+    sinfo->last_changed_job = NULL;
+}
+
+/* Job added to end of list, its runned
+ * and not completed processes indexed.
+ * Id of job chosen before. */
 void register_job(shell_info *sinfo, job *j)
 {
+    process *p;
+
+    j->prev = sinfo->last_job;
+    j->next = NULL;
     if (sinfo->first_job == NULL)
         sinfo->last_job = sinfo->first_job = j;
     else
         sinfo->last_job = sinfo->last_job->next = j;
+
+    for (p = j->processes; p < JOB_PROCESSES_END(j); ++p) {
+        if (p->pid > 0 && !p->completed)
+            index_process(sinfo, p);
+    }
 }
 
 void unregister_job(shell_info *sinfo, job *j)
 {
-    job *prev_j = NULL;
-    job *cur_j = sinfo->first_job;
-    job *next_j = NULL;
-
-    while (cur_j != NULL) {
-        next_j = cur_j->next;
+    process *p;
 
-        if (cur_j == j) {
-            if (cur_j == sinfo->first_job)
-                sinfo->first_job = next_j;
-            else
-                prev_j->next = next_j;
+    if (j->prev == NULL)
+        sinfo->first_job = j->next;
+    else
+        j->prev->next = j->next;
 
-            if (sinfo->last_job == cur_j)
-            /* if (next_j == NULL) *//* equal conditions */
-                sinfo->last_job = prev_j;
+    if (j->next == NULL)
+        sinfo->last_job = j->prev;
+    else
+        j->next->prev = j->prev;
 
-            break;
-        }
+    j->prev = j->next = NULL;
 
-        prev_j = cur_j;
-        cur_j = next_j;
+    for (p = j->processes; p < JOB_PROCESSES_END(j); ++p) {
+        if (p->pid > 0 && !p->completed)
+            unindex_process(sinfo, p);
     }
+    unmark_job_changed(sinfo, j);
+    free_job_id(sinfo, j->id);
 
     /* Set new current job ID */
     if (j->id == sinfo->cur_job_id) {
@@ -197,12 +531,11 @@ void unregister_job(shell_info *sinfo, job *j)
  * 0, otherwise. */
 int job_is_stopped(job *j)
 {
-    process *p = j->first_process;
+    process *p;
 
-    while (p != NULL) {
+    for (p = j->processes; p < JOB_PROCESSES_END(j); ++p) {
         if (!p->stopped)
             return 0;
-        p = p->next;
     }
 
     return 1;
@@ -213,23 +546,171 @@ int job_is_stopped(job *j)
  * 0, otherwise. */
 int job_is_completed(job *j)
 {
-    process *p = j->first_process;
+    process *p;
 
-    while (p != NULL) {
+    for (p = j->processes; p < JOB_PROCESSES_END(j); ++p) {
         if (!p->completed)
             return 0;
-        p = p->next;
     }
 
     return 1;
 }
 
+/* Exit status of last process of job, see
+ * typedef process */
+int job_exit_status(job *j)
+{
+    return (JOB_PROCESSES_END(j) - 1)->exit_status;
+}
+
+/* Command name for messages */
+const char *job_name(job *j)
+{
+    if (j->processes->argv == NULL)
+        return "subshell";
+    return *(j->processes->argv);
+}
+
+/* Variables set by set_shell_var(): strings
+ * owned by shell. Ones before shell_vars_mark
+ * may be referenced by saved environment. */
+static char **shell_vars = NULL;
+static unsigned int count_shell_vars = 0;
+static unsigned int size_shell_vars = 0;
+static unsigned int shell_vars_mark = 0;
+
+/* Array assigned to environ by restore_environ() */
+static char **shell_environ = NULL;
+
+/* Free variable of shell, which was replaced
+ * in environment, if no saved environment
+ * refers to it */
+void forget_shell_var(char *var)
+{
+    unsigned int i;
+
+    for (i = shell_vars_mark; i < count_shell_vars; ++i) {
+        if (shell_vars[i] == var) {
+            free(var);
+            shell_vars[i] = shell_vars[--count_shell_vars];
+            return;
+        }
+    }
+}
+
+/* As setenv(), but string owned by shell,
+ * so it freed, when replaced or forgotten
+ * by restore_environ() */
+void set_shell_var(const char *name, const char *value)
+{
+    unsigned int len = strlen(name);
+    char *old = getenv(name);
+    char *var = (char *) malloc(len + strlen(value) + 2);
+
+    sprintf(var, "%s=%s", name, value);
+    putenv(var);
+    if (old != NULL)
+        forget_shell_var(old - len - 1);
+
+    if (count_shell_vars == size_shell_vars) {
+        size_shell_vars = (size_shell_vars == 0) ?
+            SHELL_VARS_SIZE : size_shell_vars * 2;
+        shell_vars = (char **) realloc(shell_vars,
+            sizeof(char *) * size_shell_vars);
+    }
+    shell_vars[count_shell_vars++] = var;
+}
+
+/* Shallow copy of environ: strings
+ * not copied, see restore_environ() */
+void save_environ(environ_state *state)
+{
+    unsigned int count = 0;
+
+    while (environ != NULL && environ[count] != NULL)
+        ++count;
+
+    state->vars = (char **) malloc(sizeof(char *) * (count + 1));
+    memcpy(state->vars, environ, sizeof(char *) * count);
+    state->vars[count] = NULL;
+
+    state->shell_vars_mark = shell_vars_mark;
+    shell_vars_mark = count_shell_vars;
+}
+
+/* Saved array becomes environ. Variables of
+ * shell set after save_environ() not referenced
+ * by it and freed, as previous array. */
+void restore_environ(environ_state *state)
+{
+    unsigned int i;
+
+    for (i = shell_vars_mark; i < count_shell_vars; ++i)
+        free(shell_vars[i]);
+    count_shell_vars = shell_vars_mark;
+    shell_vars_mark = state->shell_vars_mark;
+
+    environ = state->vars;
+    free(shell_environ);
+    shell_environ = state->vars;
+}
+
 void mark_job_as_runned(job *j)
 {
-    process *p = j->first_process;
+    process *p;
 
-    while (p != NULL) {
+    for (p = j->processes; p < JOB_PROCESSES_END(j); ++p) {
         p->stopped = 0;
-        p = p->next;
     }
+    j->notified = 0;
+}
+
+/* Descriptor opened by shell for job */
+void add_job_fd(job *j, int fd)
+{
+    j->fds[(j->count_fds)++] = fd;
+}
+
+/* Close descriptor, if it opened for job
+ * and not closed yet. Standard channels of
+ * shell are not in table. */
+void close_job_fd(job *j, int fd)
+{
+    unsigned int i;
+
+    for (i = 0; i < j->count_fds; ++i) {
+        if (j->fds[i] == fd) {
+            close(fd);
+            j->fds[i] = -1;
+            return;
+        }
+    }
+}
+
+/* Close all descriptors of job left opened:
+ * after launch or on error */
+void close_job_fds(job *j)
+{
+    unsigned int i;
+
+    for (i = 0; i < j->count_fds; ++i) {
+        if (j->fds[i] != -1) {
+            close(j->fds[i]);
+            j->fds[i] = -1;
+        }
+    }
+}
+
+/* FNV-1a, 32 bit: of command lines
+ * (plan_cache) and names (path_cache) */
+unsigned long fnv_hash(const char *str, unsigned int len)
+{
+    unsigned long hash = 2166136261UL;
+
+    while (len-- > 0) {
+        hash ^= (unsigned char) *(str++);
+        hash = (hash * 16777619UL) & 0xffffffffUL;
+    }
+
+    return hash;
 }
@@ -3,19 +3,46 @@
 
 #include "runner.h"
 
+/* Self-pipe of SIGCHLD: read and write ends */
+extern int sigchld_pipe[2];
+
 void new_shell_info(shell_info *sinfo);
 void set_sig_ign(void);
 void set_sig_dfl(void);
+void init_sigchld(void);
+void wait_sigchld(void);
+void drain_sigchld(void);
 void print_prompt1(void);
 void print_prompt2(void);
 
-process *pipeline_item_to_process(cmd_pipeline_item *simple_cmd);
-job *make_job();
+char **pack_argv(arena *a, char **argv);
+void init_process(process *p, arena *a, cmd_node *cmd);
+job *make_job(cmd_tree *tree, cmd_node *pipeline);
 void destroy_job(job *j);
+void grow_pid_index(shell_info *sinfo);
+void index_process(shell_info *sinfo, process *p);
+void unindex_process(shell_info *sinfo, process *p);
+process *find_process(shell_info *sinfo, pid_t pid);
+int alloc_job_id(shell_info *sinfo);
+void free_job_id(shell_info *sinfo, int id);
+void mark_job_changed(shell_info *sinfo, job *j);
+job *take_changed_job(shell_info *sinfo);
+void unmark_job_changed(shell_info *sinfo, job *j);
+void clear_job_tables(shell_info *sinfo);
 void register_job(shell_info *sinfo, job *j);
 void unregister_job(shell_info *sinfo, job *j);
 int job_is_stopped(job *j);
 int job_is_completed(job *j);
+int job_exit_status(job *j);
+const char *job_name(job *j);
+void forget_shell_var(char *var);
+void set_shell_var(const char *name, const char *value);
+void save_environ(environ_state *state);
+void restore_environ(environ_state *state);
 void mark_job_as_runned(job *j);
+void add_job_fd(job *j, int fd);
+void close_job_fd(job *j, int fd);
+void close_job_fds(job *j);
+unsigned long fnv_hash(const char *str, unsigned int len);
 
 #endif
@@ -1,94 +1,74 @@
 #include <stdlib.h>
+#include <string.h>
 
 #include "word_buffer.h"
 
-void new_word_buffer(word_buffer *wbuf)
+void new_word_buffer(word_buffer *wbuf, arena *a)
 {
 /*  word_buffer *wbuf = (word_buffer *) malloc(sizeof(word_buffer)); */
-    wbuf->first_item = NULL;
-    wbuf->last_item = NULL;
+    wbuf->words = wbuf->inline_words;
     wbuf->count_words = 0;
+    wbuf->size = WORD_BUFFER_INLINE_SIZE;
+    wbuf->arena = a;
 }
 
-void add_to_word_buffer(word_buffer *wbuf, char *str)
+/* Old array stays in arena until it released */
+void grow_word_buffer(word_buffer *wbuf)
 {
-    if (wbuf->first_item == NULL) {
-        wbuf->last_item = wbuf->first_item =
-            (word_item *) malloc(sizeof(word_item));
-    } else {
-        wbuf->last_item = wbuf->last_item->next =
-            (word_item *) malloc(sizeof(word_item));
-    }
+    char **words = (char **) arena_alloc(wbuf->arena,
+        sizeof(char *) * wbuf->size * 2);
 
-    wbuf->last_item->next = NULL;
-    wbuf->last_item->str = str;
-    ++(wbuf->count_words);
+    memcpy(words, wbuf->words, sizeof(char *) * wbuf->count_words);
+    wbuf->words = words;
+    wbuf->size *= 2;
 }
 
-void clear_word_buffer(word_buffer *wbuf, int destroy_str)
+void add_to_word_buffer(word_buffer *wbuf, char *str)
 {
-    word_item *current = wbuf->first_item;
-    word_item *next;
-
-    while (current != NULL) {
-        next = current->next;
-        if (destroy_str)
-            free(current->str);
-        free(current);
-        current = next;
-    }
+    /* Keep place for NULL */
+    if (wbuf->count_words + 1 == wbuf->size)
+        grow_word_buffer(wbuf);
+
+    wbuf->words[(wbuf->count_words)++] = str;
+}
 
-    wbuf->last_item = wbuf->first_item = NULL;
+/* Arrays stay in arena until it released */
+void clear_word_buffer(word_buffer *wbuf)
+{
+    wbuf->words = wbuf->inline_words;
     wbuf->count_words = 0;
+    wbuf->size = WORD_BUFFER_INLINE_SIZE;
 }
 
+/* Array in arena given up as argv without
+ * copying, inline words copied to arena.
+ * If !destroy_me, argv may share array with
+ * buffer, so buffer must be cleared before
+ * adding next words. */
 char **convert_to_argv(word_buffer *wbuf, int destroy_me)
 {
-    word_item *current = wbuf->first_item;
-    word_item *next;
-    char **argv = (char **) malloc(sizeof(char *)
-        * (wbuf->count_words + 1));
-    char **cur_str = argv;
-
-    while (current != NULL) {
-        next = current->next;
-        *cur_str = current->str;
-        if (destroy_me)
-            free(current);
-        ++cur_str;
-        current = next;
-    }
+    char **argv = wbuf->words;
 
-    if (destroy_me) {
-        wbuf->last_item = wbuf->first_item = NULL;
-        wbuf->count_words = 0;
+    if (argv == wbuf->inline_words) {
+        argv = (char **) arena_alloc(wbuf->arena,
+            sizeof(char *) * (wbuf->count_words + 1));
+        memcpy(argv, wbuf->words, sizeof(char *) * wbuf->count_words);
     }
 
-    *cur_str = NULL;
+    argv[wbuf->count_words] = NULL;
+
+    if (destroy_me)
+        clear_word_buffer(wbuf);
+
     return argv;
 }
 
 /* Returns NULL, if word_buffer empty */
 char *get_last_word(word_buffer *wbuf)
 {
-    if (wbuf->last_item == NULL)
+    if (wbuf->count_words == 0)
         return NULL;
-    return wbuf->last_item->str;
-}
-
-void destroy_argv(char **argv)
-{
-    char **cur_str = argv;
-
-    if (argv == NULL)
-        return;
-
-    while (*cur_str) {
-        free(*cur_str);
-        ++cur_str;
-    }
-
-    free(argv);
+    return wbuf->words[wbuf->count_words - 1];
 }
 
 void print_argv(FILE *stream, char **argv)
@@ -104,7 +84,7 @@ void print_argv(FILE *stream, char **argv)
 }
 
 /*
-gcc -g -Wall -ansi -pedantic word_buffer.c -o word_buffer
+gcc -g -Wall -ansi -pedantic word_buffer.c arena.c input.c scan.c -o word_buffer
 */
 
 #if 0
@@ -114,9 +94,11 @@ int main(int argc, char **argv)
     char **cur_argv;
     char **my_argv;
     word_buffer wbuf;
+    arena *a;
 
     do {
-        new_word_buffer(&wbuf);
+        a = make_arena();
+        new_word_buffer(&wbuf, a);
         cur_argv = argv;
 
         while (*cur_argv != NULL) {
@@ -128,25 +110,17 @@ int main(int argc, char **argv)
         my_argv = convert_to_argv(&wbuf, 0);
         print_argv(my_argv);
         printf("Last string: [%s]\n", get_last_word(&wbuf));
-        /* Use it, only if strings in dynamic memory
-        clear_word_buffer(&wbuf, 1); */
-        clear_word_buffer(&wbuf, 0);
-        free(my_argv);
+        clear_word_buffer(&wbuf);
 #elif (DEBUG_WORD_BUFFER_VAR == 2)
         my_argv = convert_to_argv(&wbuf, 0);
         print_argv(my_argv);
         printf("Last string: [%s]\n", get_last_word(&wbuf));
-        clear_word_buffer(&wbuf, 0);
-        /* Use it, only if strings in dynamic memory
-        destroy_argv(my_argv); */
-        free(my_argv);
+        clear_word_buffer(&wbuf);
 #else
         my_argv = convert_to_argv(&wbuf, 1);
         print_argv(my_argv);
-        /* Use it, only if strings in dynamic memory
-        destroy_argv(my_argv); */
-        free(my_argv);
 #endif
+        release_arena(a);
     } while (1);
 
     return 0;
@@ -2,24 +2,32 @@
 #define WORD_BUFFER_H_SENTRY
 
 #include <stdio.h>
+#include "arena.h"
 
-typedef struct word_item {
-	struct word_item *next;
-	char *str;
-} word_item;
+/* Count of words stored in word_buffer itself.
+ * Bigger commands use array in arena, which
+ * doubles on growth. */
+#ifndef WORD_BUFFER_INLINE_SIZE
+#define WORD_BUFFER_INLINE_SIZE 8
+#endif
 
+/* Arrays and argv allocated in arena,
+ * so nothing to free. */
 typedef struct word_buffer {
-    word_item *first_item;
-    word_item *last_item;
+    /* inline_words or array in arena,
+     * always has place for NULL at end */
+    char **words;
     unsigned int count_words;
+    unsigned int size;
+    char *inline_words[WORD_BUFFER_INLINE_SIZE];
+    arena *arena;
 } word_buffer;
 
-void new_word_buffer(word_buffer *wbuf);
+void new_word_buffer(word_buffer *wbuf, arena *a);
 void add_to_word_buffer(word_buffer *wbuf, char *str);
-void clear_word_buffer(word_buffer *wbuf, int destroy_str);
+void clear_word_buffer(word_buffer *wbuf);
 char **convert_to_argv(word_buffer *wbuf, int destroy_me);
 char *get_last_word(word_buffer *wbuf);
-void destroy_argv(char **argv);
 
 void print_argv(FILE *stream, char **argv);
 